@@ -0,0 +1,615 @@
+#include "benchmarks.h"
+#include "base64.h"
+#include "eventdecoder.h"
+#include "framecolumns.h"
+#include "seekindex.h"
+#include "slippieventlayout.h"
+#include "slpfile.h"
+#include "streamworker.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+
+// every measurement repeats its work for at least this many ms
+const qint64 MIN_BENCH_TIME = 500;
+
+// the frame events of a replay, found by walking the commands with the payload sizes
+struct FrameCommands {
+    quint32 version = ~0u;
+    qsizetype preFrameSize = 0, postFrameSize = 0;
+    QVector<const uchar *> preFrames, postFrames;
+};
+
+FrameCommands scanCommands(QByteArrayView events)
+{
+    FrameCommands commands;
+    quint16 payloadSizes[256] = { 0 };
+
+    forEachCommand(events, payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        const uchar *command = reinterpret_cast<const uchar *>(payload.data());
+        switch(commandByte) {
+        case EventDecoder::EVENT_GAME_START:
+            commands.version = replayVersion(command[0], command[1], command[2]);
+            break;
+        case EventDecoder::EVENT_PRE_FRAME:
+            commands.preFrames.append(command);
+            break;
+        case EventDecoder::EVENT_POST_FRAME:
+            commands.postFrames.append(command);
+            break;
+        }
+    });
+
+    commands.preFrameSize = payloadSizes[EventDecoder::EVENT_PRE_FRAME];
+    commands.postFrameSize = payloadSizes[EventDecoder::EVENT_POST_FRAME];
+    return commands;
+}
+
+// the replay as Dolphin streams it to a spectator: a connect reply, then one game event per command
+QVector<QByteArray> spectatorMessages(QByteArrayView events)
+{
+    QVector<QByteArray> messages;
+    messages.append(R"({"type":"connect_reply","nick":"Bench","version":"3.16.0","cursor":0,"next_cursor":0})");
+
+    qint64 cursor = 0;
+    quint16 payloadSizes[256] = { 0 };
+
+    forEachCommand(events, payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        // with the command byte, and the length byte of the payload sizes event
+        qsizetype header = commandByte == EventDecoder::EVENT_PAYLOADS ? 2 : 1;
+        QByteArrayView command(payload.data() - header, payload.size() + header);
+
+        messages.append(R"({"type":"game_event","cursor":)" + QByteArray::number(cursor) + R"(,"next_cursor":)"
+                        + QByteArray::number(cursor + 1) + R"(,"payload":")" + command.toByteArray().toBase64() + "\"}");
+        cursor++;
+    });
+
+    return messages;
+}
+
+// average ns of one call, repeated for at least MIN_BENCH_TIME
+template<typename Function>
+qreal nsPerRun(Function function)
+{
+    int runs = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    do {
+        function();
+        runs++;
+    } while(timer.elapsed() < MIN_BENCH_TIME);
+
+    return qreal(timer.nsecsElapsed()) / runs;
+}
+
+// the fields analyzeFrame() accumulates over frames
+bool sameStats(const GameState &a, const GameState &b)
+{
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        for(int slot = 0; slot < 2; slot++) {
+            const PlayerStats &x = (slot == 0 ? a.players[i].leader : a.players[i].follower).stats;
+            const PlayerStats &y = (slot == 0 ? b.players[i].leader : b.players[i].follower).stats;
+
+            if(x.comboCount != y.comboCount || x.framesSinceLCancel != y.framesSinceLCancel
+                    || x.framesSinceFall != y.framesSinceFall || x.intangibilityFrames != y.intangibilityFrames
+                    || x.wavedashFrame != y.wavedashFrame || x.cycloneBPresses != y.cycloneBPresses) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the QDataStream extraction the field decoders replaced, the reference for their speed and values.
+// reads past the end of a shorter payload leave 0 like the defaults of the decoders
+void referencePreFrame(PreFrameData &d, const uchar *command, qsizetype size)
+{
+    QDataStream stream(QByteArray::fromRawData(reinterpret_cast<const char *>(command), size));
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream >> d.frameNumber >> d.playerIndex >> d.isFollower >> d.randomSeed >> d.actionStateId
+        >> d.posX >> d.posY >> d.facingDirection >> d.joyStickX >> d.joyStickY >> d.cstickX >> d.cstickY >> d.triggerValue
+        >> d.processedButtons >> d.physicalButtons
+        >> d.physicalLTrigger >> d.physicalRTrigger
+        >> d.ucfX >> d.percent >> d.ucfY;
+}
+
+void referencePostFrame(PostFrameData &d, const uchar *command, qsizetype size)
+{
+    QDataStream stream(QByteArray::fromRawData(reinterpret_cast<const char *>(command), size));
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream >> d.frameNumber >> d.playerIndex >> d.isFollower >> d.charId >> d.actionStateId
+        >> d.posX >> d.posY >> d.facingDirection >> d.percent >> d.shieldSize
+        >> d.lastHitAttackId >> d.comboCount >> d.lastHitBy >> d.stocks >> d.actionStateFrameCounter;
+
+    // was read into a bit field union, byte n of the spec goes to bits 8 * (n - 1) of stateFlags
+    quint8 flags[5] = { 0 };
+    stream.readRawData(reinterpret_cast<char *>(flags), 5);
+
+    d.stateFlags = 0;
+    for(int i = 0; i < 5; i++) {
+        d.stateFlags |= quint64(flags[i]) << (8 * i);
+    }
+
+    stream >> d.actionStateData >> d.airborne >> d.lastGroundId
+        >> d.jumpsRemaining >> d.lCancelStatus >> d.hurtboxCollisionState
+        >> d.xSpeedSelfAir >> d.ySpeedSelf >> d.xSpeedAttack >> d.ySpeedAttack >> d.xSpeedSelfGround
+        >> d.hitlagFrameRemaining >> d.animationIndex;
+}
+
+// bitwise, so NaNs in the payload compare equal
+bool sameFloat(float a, float b)
+{
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+bool samePreFrame(const PreFrameData &a, const PreFrameData &b)
+{
+    return a.frameNumber == b.frameNumber && a.playerIndex == b.playerIndex && a.isFollower == b.isFollower
+        && a.randomSeed == b.randomSeed && a.actionStateId == b.actionStateId
+        && sameFloat(a.posX, b.posX) && sameFloat(a.posY, b.posY) && sameFloat(a.facingDirection, b.facingDirection)
+        && sameFloat(a.joyStickX, b.joyStickX) && sameFloat(a.joyStickY, b.joyStickY)
+        && sameFloat(a.cstickX, b.cstickX) && sameFloat(a.cstickY, b.cstickY) && sameFloat(a.triggerValue, b.triggerValue)
+        && a.processedButtons == b.processedButtons && a.physicalButtons == b.physicalButtons
+        && sameFloat(a.physicalLTrigger, b.physicalLTrigger) && sameFloat(a.physicalRTrigger, b.physicalRTrigger)
+        && a.ucfX == b.ucfX && sameFloat(a.percent, b.percent) && a.ucfY == b.ucfY;
+}
+
+bool samePostFrame(const PostFrameData &a, const PostFrameData &b)
+{
+    return a.frameNumber == b.frameNumber && a.playerIndex == b.playerIndex && a.isFollower == b.isFollower
+        && a.charId == b.charId && a.actionStateId == b.actionStateId
+        && sameFloat(a.posX, b.posX) && sameFloat(a.posY, b.posY) && sameFloat(a.facingDirection, b.facingDirection)
+        && sameFloat(a.percent, b.percent) && sameFloat(a.shieldSize, b.shieldSize)
+        && a.lastHitAttackId == b.lastHitAttackId && a.comboCount == b.comboCount && a.lastHitBy == b.lastHitBy
+        && a.stocks == b.stocks && sameFloat(a.actionStateFrameCounter, b.actionStateFrameCounter)
+        && a.stateFlags == b.stateFlags && sameFloat(a.actionStateData, b.actionStateData) && a.airborne == b.airborne
+        && a.lastGroundId == b.lastGroundId && a.jumpsRemaining == b.jumpsRemaining
+        && a.lCancelStatus == b.lCancelStatus && a.hurtboxCollisionState == b.hurtboxCollisionState
+        && sameFloat(a.xSpeedSelfAir, b.xSpeedSelfAir) && sameFloat(a.ySpeedSelf, b.ySpeedSelf)
+        && sameFloat(a.xSpeedAttack, b.xSpeedAttack) && sameFloat(a.ySpeedAttack, b.ySpeedAttack)
+        && sameFloat(a.xSpeedSelfGround, b.xSpeedSelfGround) && sameFloat(a.hitlagFrameRemaining, b.hitlagFrameRemaining)
+        && a.animationIndex == b.animationIndex;
+}
+
+QString versionString(quint32 version)
+{
+    return QString("%1.%2.%3").arg(version >> 24).arg((version >> 16) & 0xff).arg((version >> 8) & 0xff);
+}
+
+} // namespace
+
+int benchBase64()
+{
+    QTextStream out(stdout);
+
+    // the gecko code list is sent once at the start of every game, then about one frame of events per message.
+    // random bytes, the cost does not depend on the content
+    struct Payloads {
+        const char *name;
+        qsizetype size;
+        int count;
+    };
+    const Payloads kinds[] = {
+        { "gecko list", 54 * 1024, 4 },
+        { "frame, 2 characters", 330, 1024 },
+        { "frame, 4 characters", 630, 1024 },
+    };
+
+    QRandomGenerator random(1);
+    int mismatches = 0;
+
+    out << "payload\tbytes\told ns\tnew ns\told MB/s\tnew MB/s\tspeedup" << Qt::endl;
+
+    for(const Payloads &kind : kinds) {
+        QVector<QByteArray> raw, text;
+        QVector<QString> strings;
+        for(int i = 0; i < kind.count; i++) {
+            QByteArray bytes(kind.size, Qt::Uninitialized);
+            for(char &c : bytes) {
+                c = char(random.generate());
+            }
+            raw.append(bytes);
+            text.append(bytes.toBase64());
+            strings.append(QString::fromLatin1(text.last()));
+        }
+
+        // the decoder's input buffer
+        QByteArray buffer(kind.size, Qt::Uninitialized);
+        quint64 checksum = 0;
+
+        // before: the payload as a QString of the parsed JSON document
+        auto decodeOld = [&](int i) {
+            QByteArray data = QByteArray::fromBase64(strings.at(i).toLocal8Bit());
+            std::memcpy(buffer.data(), data.constData(), data.size());
+            return data.size();
+        };
+        // now: straight from the message text into the buffer
+        auto decodeNew = [&](int i) {
+            const QByteArray &t = text.at(i);
+            return Base64::decode(t.constData(), t.size(), buffer.data());
+        };
+
+        for(int i = 0; i < kind.count; i++) {
+            qsizetype oldSize = decodeOld(i);
+            QByteArray oldBytes = buffer;
+            qsizetype newSize = decodeNew(i);
+
+            if(oldSize != kind.size || newSize != kind.size || buffer != oldBytes || buffer != raw.at(i)) {
+                mismatches++;
+            }
+        }
+
+        qreal oldTime = nsPerRun([&]() {
+            for(int i = 0; i < kind.count; i++) {
+                checksum += decodeOld(i);
+            }
+        }) / kind.count;
+
+        qreal newTime = nsPerRun([&]() {
+            for(int i = 0; i < kind.count; i++) {
+                checksum += decodeNew(i);
+            }
+        }) / kind.count;
+
+        out << kind.name << '\t' << kind.size << '\t' << QString::number(oldTime, 'f', 1) << '\t'
+            << QString::number(newTime, 'f', 1) << '\t' << qRound64(kind.size * 1e3 / oldTime) << '\t'
+            << qRound64(kind.size * 1e3 / newTime) << '\t' << QString::number(oldTime / newTime, 'f', 2)
+            << " (checksum " << (checksum & 0xff) << ")" << Qt::endl;
+    }
+
+    if(mismatches > 0) {
+        out << mismatches << " payloads decoded differently" << Qt::endl;
+        return 1;
+    }
+
+    out << "both decode every payload to the same bytes" << Qt::endl;
+    return 0;
+}
+
+int benchDecode(const QString &fileName)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SlpFile file;
+    if(!file.open(fileName)) {
+        err << "Could not open replay " << fileName << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QByteArrayView events = file.rawEvents();
+    FrameCommands commands = scanCommands(events);
+
+    if(commands.preFrames.isEmpty() || commands.postFrames.isEmpty()) {
+        err << "No frame events in " << fileName << Qt::endl;
+        return 1;
+    }
+
+    qsizetype frameEvents = commands.preFrames.size() + commands.postFrames.size();
+
+    out << "replay " << fileName << ", version " << versionString(commands.version) << ", "
+        << commands.preFrames.size() << " pre and " << commands.postFrames.size() << " post frame events" << Qt::endl;
+
+    // keeps the decoded values alive
+    quint64 checksum = 0;
+
+    PreFrameData::Decoder preDecoder = PreFrameData::decoder(commands.version, commands.preFrameSize);
+    qreal preTime = nsPerRun([&]() {
+        PreFrameData d;
+        for(const uchar *command : std::as_const(commands.preFrames)) {
+            preDecoder(d, command);
+            checksum += d.processedButtons + d.fieldCount;
+        }
+    });
+
+    PostFrameData::Decoder postDecoder = PostFrameData::decoder(commands.version, commands.postFrameSize);
+    qreal postTime = nsPerRun([&]() {
+        PostFrameData d;
+        for(const uchar *command : std::as_const(commands.postFrames)) {
+            postDecoder(d, command);
+            checksum += d.stateFlags + d.fieldCount;
+        }
+    });
+
+    qreal preReferenceTime = nsPerRun([&]() {
+        PreFrameData d;
+        for(const uchar *command : std::as_const(commands.preFrames)) {
+            referencePreFrame(d, command, commands.preFrameSize);
+            checksum += d.processedButtons;
+        }
+    });
+
+    qreal postReferenceTime = nsPerRun([&]() {
+        PostFrameData d;
+        for(const uchar *command : std::as_const(commands.postFrames)) {
+            referencePostFrame(d, command, commands.postFrameSize);
+            checksum += d.stateFlags;
+        }
+    });
+
+    // every field of every event has to match the reference
+    qsizetype preMismatches = 0, postMismatches = 0;
+    for(const uchar *command : std::as_const(commands.preFrames)) {
+        PreFrameData decoded, reference;
+        preDecoder(decoded, command);
+        referencePreFrame(reference, command, commands.preFrameSize);
+        preMismatches += samePreFrame(decoded, reference) ? 0 : 1;
+    }
+    for(const uchar *command : std::as_const(commands.postFrames)) {
+        PostFrameData decoded, reference;
+        postDecoder(decoded, command);
+        referencePostFrame(reference, command, commands.postFrameSize);
+        postMismatches += samePostFrame(decoded, reference) ? 0 : 1;
+    }
+
+    EventDecoder decoder;
+    decoder.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+
+    int frames = 0;
+    qreal fullTime = nsPerRun([&]() {
+        decoder.resetStream();
+        frames = 0;
+        decoder.parseEvents(events, 0, &frames);
+    });
+
+    // the same events into columns, then a whole-game pass over them: distance traveled per character
+    FrameColumns columns;
+    qreal columnTime = nsPerRun([&]() {
+        columns.decode(events);
+    });
+
+    qreal distance = 0;
+    qreal columnAnalysisTime = nsPerRun([&]() {
+        distance = 0;
+        for(int c = 0; c < FrameColumns::NUM_CHARACTERS; c++) {
+            const FrameColumns::Character &character = columns.character(c);
+            const float *x = character.posX.constData(), *y = character.posY.constData();
+
+            for(qsizetype i = 1; i < character.size(); i++) {
+                distance += std::hypot(x[i] - x[i - 1], y[i] - y[i - 1]);
+            }
+        }
+    });
+
+    qsizetype columnFrames = qMax<qsizetype>(1, columns.frameCount());
+
+    out << "pre frame decode:  " << QString::number(preTime / commands.preFrames.size(), 'f', 2) << " ns/event, QDataStream "
+        << QString::number(preReferenceTime / commands.preFrames.size(), 'f', 2) << " ns/event ("
+        << QString::number(preReferenceTime / preTime, 'f', 1) << "x)" << Qt::endl;
+    out << "post frame decode: " << QString::number(postTime / commands.postFrames.size(), 'f', 2) << " ns/event, QDataStream "
+        << QString::number(postReferenceTime / commands.postFrames.size(), 'f', 2) << " ns/event ("
+        << QString::number(postReferenceTime / postTime, 'f', 1) << "x)" << Qt::endl;
+    out << "EventDecoder with analysis: " << QString::number(fullTime / frameEvents, 'f', 2) << " ns per frame event, "
+        << QString::number(fullTime / qMax(1, frames) / 1000, 'f', 2) << " us per frame" << Qt::endl;
+    out << "columnar decode: " << QString::number(columnTime / frameEvents, 'f', 2) << " ns per frame event, "
+        << qRound64(columnFrames * 1e9 / columnTime) << " frames/s per core" << Qt::endl;
+    out << "column pass (distance traveled): " << QString::number(columnAnalysisTime / columnFrames, 'f', 2) << " ns per frame" << Qt::endl;
+    out << "(checksum " << (checksum & 0xff) << ", distance " << qRound64(distance) << ")" << Qt::endl;
+
+    if(preMismatches > 0 || postMismatches > 0) {
+        err << preMismatches << " pre and " << postMismatches << " post frame events decoded differently than with QDataStream"
+            << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int benchStreams(const QString &fileName, int maxStreams)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SlpFile file;
+    if(!file.open(fileName)) {
+        err << "Could not open replay " << fileName << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QByteArrayView events = file.rawEvents();
+
+    // the whole replay decoded directly, each stream has to end with the same stats
+    int frames = 0;
+    EventDecoder reference;
+    reference.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+    reference.parseEvents(events, 0, &frames);
+
+    if(frames == 0) {
+        err << "No frame bookends in " << fileName << ", needs a replay of version 3.0.0 or later" << Qt::endl;
+        return 1;
+    }
+
+    QVector<QByteArray> messages = spectatorMessages(events);
+
+    // one pass of one stream, each stream gets about MIN_BENCH_TIME of work
+    QElapsedTimer passTimer;
+    passTimer.start();
+    {
+        EventDecoder decoder;
+        decoder.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+        for(const QByteArray &message : std::as_const(messages)) {
+            decoder.parseMessageData(message);
+        }
+    }
+    qint64 passTime = qMax<qint64>(1, passTimer.nsecsElapsed());
+
+    int passes = int(qMax<qint64>(1, MIN_BENCH_TIME * 1000000 / passTime));
+
+    out << "replay " << fileName << ", " << frames << " frames as " << messages.size() << " messages, " << passes
+        << " passes per stream, " << QThread::idealThreadCount() << " cores" << Qt::endl;
+    out << "streams\tms\tframes/s\tspeedup\tefficiency\tmax queue\tbatch" << Qt::endl;
+
+    qreal baseline = 0;
+    for(int streams = 1; streams <= maxStreams; streams++) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(streams);
+
+        QVector<QSharedPointer<EventDecoder>> decoders;
+        QVector<QSharedPointer<StreamStats>> stats;
+        QVector<QSharedPointer<StreamWorker>> workers;
+        for(int stream = 0; stream < streams; stream++) {
+            decoders.append(QSharedPointer<EventDecoder>::create());
+            decoders.last()->setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+            stats.append(QSharedPointer<StreamStats>::create());
+            workers.append(QSharedPointer<StreamWorker>::create(decoders.last(), stats.last(), &pool));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // the messages of all streams interleaved like the packets of one ENet host,
+        // at most one more pass is queued while a stream works on the previous one
+        for(int pass = 0; pass < passes; pass++) {
+            for(int stream = 0; stream < streams; stream++) {
+                while(stats[stream]->packets < quint64(qMax(0, pass - 1)) * messages.size()) {
+                    QThread::yieldCurrentThread();
+                }
+
+                workers[stream]->post([decoder = decoders[stream]]() {
+                    decoder->resetConnection();
+                });
+            }
+
+            for(const QByteArray &message : std::as_const(messages)) {
+                for(int stream = 0; stream < streams; stream++) {
+                    workers[stream]->postMessage(message, nullptr, nullptr);
+                }
+            }
+        }
+
+        pool.waitForDone();
+
+        qreal seconds = timer.nsecsElapsed() / 1e9;
+        qreal throughput = qreal(streams) * passes * frames / seconds;
+        if(streams == 1) {
+            baseline = throughput;
+        }
+
+        int maxQueueDepth = 0, mismatches = 0;
+        quint64 packets = 0, batches = 0;
+        for(int stream = 0; stream < streams; stream++) {
+            maxQueueDepth = qMax(maxQueueDepth, stats[stream]->maxQueueDepth.load());
+            packets += stats[stream]->packets;
+            batches += stats[stream]->batches;
+
+            if(!sameStats(decoders[stream]->gameState(), reference.gameState())) {
+                mismatches++;
+            }
+        }
+
+        qreal speedup = throughput / baseline;
+        out << streams << '\t' << qRound64(seconds * 1000) << '\t' << qRound64(throughput) << '\t'
+            << QString::number(speedup, 'f', 2) << '\t' << QString::number(speedup / streams, 'f', 2) << '\t'
+            << maxQueueDepth << '\t' << QString::number(qreal(packets) / qMax<quint64>(1, batches), 'f', 1) << Qt::endl;
+
+        if(mismatches > 0) {
+            err << mismatches << " of " << streams << " streams ended with other stats than the direct decode" << Qt::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int benchSeek(const QString &fileName)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SlpFile file;
+    if(!file.open(fileName)) {
+        err << "Could not open replay " << fileName << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QByteArrayView events = file.rawEvents();
+
+    SeekIndex index;
+    bool built = false;
+    qreal buildTime = nsPerRun([&]() {
+        built = index.build(events);
+    });
+
+    EventDecoder decoder;
+    decoder.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+
+    int frames = 0;
+    decoder.parseEvents(events, 0, &frames);
+
+    if(!built || frames == 0) {
+        err << "No frame bookends in " << fileName << ", needs a replay of version 3.0.0 or later" << Qt::endl;
+        return 1;
+    }
+
+    qint64 indexSize = index.byteSize();
+    qreal minutes = frames / 3600.0;
+
+    out << "replay " << fileName << ", " << frames << " frames, " << events.size() << " bytes of events" << Qt::endl;
+    out << "seek index: " << index.keyframes().size() << " keyframes every " << SeekIndex::KEYFRAME_INTERVAL << " frames, "
+        << indexSize << " bytes (" << QString::number(qreal(indexSize) / qMax<qsizetype>(1, index.keyframes().size()), 'f', 1)
+        << " per keyframe, " << qRound64(indexSize / qMax(minutes, 1.0 / 60)) << " per minute), built in "
+        << QString::number(buildTime / 1e6, 'f', 2) << " ms" << Qt::endl;
+
+    // the same targets for both, fixed seed so runs compare
+    const int SEEKS = 200;
+    QRandomGenerator random(1);
+    QVector<qint32> targets;
+    for(int i = 0; i < SEEKS; i++) {
+        targets.append(FIRST_FRAME + qint32(random.bounded(frames)));
+    }
+
+    qint64 seekTotal = 0, seekMax = 0, startTotal = 0, startMax = 0;
+    int mismatches = 0;
+    EventDecoder reference;
+    reference.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+
+    for(qint32 target : std::as_const(targets)) {
+        QElapsedTimer timer;
+        timer.start();
+        qsizetype position = index.seek(decoder, events, target);
+        decoder.flush();
+        qint64 seekTime = timer.nsecsElapsed();
+
+        // every event from the game start up to the same position
+        timer.start();
+        reference.resetStream();
+        reference.parseEvents(events.first(position));
+        reference.flush();
+        qint64 startTime = timer.nsecsElapsed();
+
+        seekTotal += seekTime;
+        seekMax = qMax(seekMax, seekTime);
+        startTotal += startTime;
+        startMax = qMax(startMax, startTime);
+
+        if(!sameStats(decoder.gameState(), reference.gameState())) {
+            mismatches++;
+        }
+    }
+
+    out << "seek:            " << QString::number(seekTotal / SEEKS / 1000.0, 'f', 1) << " us average, "
+        << QString::number(seekMax / 1000.0, 'f', 1) << " us max" << Qt::endl;
+    out << "from the start:  " << QString::number(startTotal / SEEKS / 1000.0, 'f', 1) << " us average, "
+        << QString::number(startMax / 1000.0, 'f', 1) << " us max" << Qt::endl;
+    out << "speedup " << QString::number(qreal(startTotal) / qMax<qint64>(1, seekTotal), 'f', 1) << "x, "
+        << mismatches << " of " << SEEKS << " seeks with other stats than the full decode" << Qt::endl;
+
+    return 0;
+}
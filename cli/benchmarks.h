@@ -0,0 +1,28 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QString>
+
+// results are printed to stdout, return the process exit code
+
+// base64 decode of game event payloads, the QString -> toLocal8Bit() -> QByteArray::fromBase64() -> copy chain
+// of the JSON document against Base64::decode() into the input buffer, on a gecko code list and on steady
+// frame sized payloads. both must produce the same bytes
+int benchBase64();
+
+// cost per pre and post frame event of the field decoders alone and of the QDataStream extraction
+// they replaced, of the whole EventDecoder with analysis and of the columnar decode, on the frame
+// events of one replay. the field decoders must read the same values as QDataStream
+int benchDecode(const QString &fileName);
+
+// total throughput of 1 to maxStreams streams on a pool of that many threads like the worker pool mode.
+// the replay is posted as base64 game event messages to one StreamWorker and EventDecoder per stream,
+// also reports the deepest queue and the average messages per drain. every stream has to end with the
+// stats of the direct decode
+int benchStreams(const QString &fileName, int maxStreams);
+
+// size and build time of the replay's seek index and the latency of seeks to random frames,
+// compared with decoding from the start. the state after each seek is checked against the full decode
+int benchSeek(const QString &fileName);
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,373 @@
+#include "checks.h"
+#include "eventdecoder.h"
+#include "slippieventlayout.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <QtEndian>
+
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+// every allocation of the process, read by --check-allocations
+static std::atomic<quint64> allocationCount = 0;
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if(void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
+
+namespace {
+
+using namespace EventLayout;
+
+// one minute each, the first games settle the heap with the messages that are built for each game
+const int GAMES = 100;
+const int WARM_UP_GAMES = 10;
+const int GAME_FRAMES = 3600;
+
+// memory of the process may move by this much after the warm up, e.g. for the heap's bookkeeping
+const qint64 MEMORY_TOLERANCE = 512 * 1024;
+
+// the memory is also read during each game
+const int MEMORY_SAMPLE_INTERVAL = 1000; // messages
+
+// the first frames of a game size the buffers of the decoder and the analysis
+const int WARM_UP_FRAMES = 600;
+
+struct PayloadSize {
+    quint8 commandByte;
+    quint16 size;
+};
+
+const PayloadSize PAYLOAD_SIZES[] = {
+    { EventDecoder::EVENT_GAME_START, 760 }, { EventDecoder::EVENT_PRE_FRAME, 64 },
+    { EventDecoder::EVENT_POST_FRAME, 84 }, { EventDecoder::EVENT_GAME_END, 6 },
+    { EventDecoder::EVENT_FRAME_START, 12 }, { EventDecoder::EVENT_ITEM_UPDATE, 44 },
+    { EventDecoder::EVENT_FRAME_BOOKEND, 8 }
+};
+
+const quint8 CHARACTERS[NUM_PLAYERS] = { 2, 20, 9, 1 };
+
+// action states that land, wavedash and l-cancel, mixed into the standing and walking ones
+const quint16 ACTION_STATES[] = { 0x0e, 0x14, 0x2a, 0x46, 0x47, 0x48, 0xb5, 0xb6 };
+
+// one command with its command byte, the fields are written big-endian at their payload offsets
+class Command
+{
+public:
+    Command(quint8 commandByte, qsizetype payloadSize)
+        : m_data(1 + payloadSize, '\0')
+    {
+        m_data[0] = char(commandByte);
+    }
+
+    template<typename T>
+    Command &set(qsizetype offset, T value)
+    {
+        qToBigEndian(value, m_data.data() + 1 + offset);
+        return *this;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QByteArray m_data;
+};
+
+struct SyntheticPlayer {
+    quint16 actionState = 0x0e;
+    float x = 0, y = 0;
+};
+
+void appendFrame(QVector<QByteArray> &commands, qint32 frame, SyntheticPlayer (&players)[2], QRandomGenerator &random)
+{
+    commands.append(Command(EventDecoder::EVENT_FRAME_START, 12).set(0, frame).set(4, random.generate()).set(8, frame).data());
+
+    for(quint8 i = 0; i < 2; i++) {
+        commands.append(Command(EventDecoder::EVENT_PRE_FRAME, 64)
+                            .set(PreFrame::FrameNumber, frame).set(PreFrame::PlayerIndex, i)
+                            .set(PreFrame::RandomSeed, random.generate()).set(PreFrame::ActionStateId, players[i].actionState)
+                            .set(PreFrame::PosX, players[i].x).set(PreFrame::PosY, players[i].y)
+                            .set(PreFrame::ProcessedButtons, random.bounded(0x1000u)).data());
+    }
+
+    for(quint8 i = 0; i < 2; i++) {
+        SyntheticPlayer &player = players[i];
+        if(random.bounded(50) == 0) {
+            player.actionState = ACTION_STATES[random.bounded(int(std::size(ACTION_STATES)))];
+        }
+
+        player.x += float(random.bounded(4.0) - 2);
+        player.y = qMax(0.0f, player.y + float(random.bounded(2.0) - 1));
+
+        commands.append(Command(EventDecoder::EVENT_POST_FRAME, 84)
+                            .set(PostFrame::FrameNumber, frame).set(PostFrame::PlayerIndex, i)
+                            .set(PostFrame::CharId, CHARACTERS[i]).set(PostFrame::ActionStateId, player.actionState)
+                            .set(PostFrame::PosX, player.x).set(PostFrame::PosY, player.y)
+                            .set(PostFrame::FacingDirection, 1.0f).set(PostFrame::ComboCount, quint8(random.bounded(4)))
+                            .set(PostFrame::Stocks, quint8(4)).set(PostFrame::Airborne, quint8(player.y > 0 ? 1 : 0))
+                            .set(PostFrame::LCancelStatus, quint8(qMax(0, random.bounded(-2, 3)))).data());
+    }
+
+    if(random.bounded(10) == 0) {
+        commands.append(Command(EventDecoder::EVENT_ITEM_UPDATE, 44)
+                            .set(ItemUpdate::FrameNumber, frame).set(ItemUpdate::TypeId, quint16(0x63))
+                            .set(ItemUpdate::State, quint8(1)).data());
+    }
+
+    commands.append(Command(EventDecoder::EVENT_FRAME_BOOKEND, 8)
+                        .set(FrameBookend::FrameNumber, frame).set(FrameBookend::LatestFinalizedFrame, frame - 3).data());
+}
+
+// the commands of a game of two players with version 3.16.0 events and online rollbacks
+QVector<QByteArray> syntheticGame(int frames, quint32 seed)
+{
+    QVector<QByteArray> commands;
+    QRandomGenerator random(seed);
+
+    // the length counts itself
+    Command payloadSizes(EventDecoder::EVENT_PAYLOADS, 1 + 3 * std::size(PAYLOAD_SIZES));
+    payloadSizes.set(0, quint8(1 + 3 * std::size(PAYLOAD_SIZES)));
+    for(size_t i = 0; i < std::size(PAYLOAD_SIZES); i++) {
+        payloadSizes.set(1 + 3 * i, PAYLOAD_SIZES[i].commandByte).set(2 + 3 * i, PAYLOAD_SIZES[i].size);
+    }
+    commands.append(payloadSizes.data());
+
+    Command gameStart(EventDecoder::EVENT_GAME_START, 760);
+    gameStart.set(0, quint8(3)).set(1, quint8(16)).set(4 + 0x0E, quint16(31));
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        // character and player type, human or empty
+        gameStart.set(4 + 0x60 + 0x24 * i, CHARACTERS[i]).set(4 + 0x61 + 0x24 * i, quint8(i < 2 ? 0 : 3));
+    }
+    commands.append(gameStart.data());
+
+    SyntheticPlayer players[2];
+    for(qint32 frame = FIRST_FRAME; frame < FIRST_FRAME + frames; frame++) {
+        // every ~20 frames the last 1 to 5 frames are resent after a rollback
+        qint32 first = frame > 0 && random.bounded(20) == 0 ? frame - random.bounded(1, 6) : frame;
+
+        for(qint32 resent = first; resent <= frame; resent++) {
+            appendFrame(commands, resent, players, random);
+        }
+    }
+
+    commands.append(Command(EventDecoder::EVENT_GAME_END, 6).set(0, quint8(2)).set(1, quint8(0xff)).data());
+    return commands;
+}
+
+// the game as Dolphin sends it to a spectator, one game event per command
+QVector<QByteArray> gameMessages(const QVector<QByteArray> &commands, qint64 &cursor)
+{
+    QVector<QByteArray> messages;
+    messages.append(R"({"type":"start_game","cursor":)" + QByteArray::number(cursor) + R"(,"next_cursor":)"
+                    + QByteArray::number(cursor) + "}");
+
+    for(const QByteArray &command : commands) {
+        messages.append(R"({"type":"game_event","cursor":)" + QByteArray::number(cursor) + R"(,"next_cursor":)"
+                        + QByteArray::number(cursor + 1) + R"(,"payload":")" + command.toBase64() + "\"}");
+        cursor++;
+    }
+
+    messages.append(R"({"type":"end_game","cursor":)" + QByteArray::number(cursor) + R"(,"next_cursor":)"
+                    + QByteArray::number(cursor) + "}");
+    return messages;
+}
+
+// one batch per message like the stream worker, the published state is read like the overlay does
+void feed(EventDecoder &decoder, const QByteArray &message)
+{
+    decoder.parseMessageData(message);
+    decoder.flush();
+
+    decoder.takeSnapshot();
+    EventDecoder::StatsEventQueue &events = decoder.statsEvents();
+    while(!events.isEmpty()) {
+        events.pop();
+    }
+}
+
+// resident memory of the process in bytes, -1 if it cannot be read on this platform
+qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile statm("/proc/self/statm");
+    if(!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // total and resident pages
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return qint64(counters.WorkingSetSize);
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+int checkMemory()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    EventDecoder decoder;
+    qint64 cursor = 0;
+    feed(decoder, R"({"type":"connect_reply","nick":"Check","version":"3.16.0","cursor":0,"next_cursor":0})");
+
+    // highest values during the warm up and during the later games
+    qsizetype warmUpCapacity = 0, capacity = 0;
+    qint64 warmUpMemory = 0, memory = 0;
+
+    for(int game = 0; game < GAMES; game++) {
+        QVector<QByteArray> messages = gameMessages(syntheticGame(GAME_FRAMES, quint32(game + 1)), cursor);
+
+        qsizetype &maxCapacity = game < WARM_UP_GAMES ? warmUpCapacity : capacity;
+        qint64 &maxMemory = game < WARM_UP_GAMES ? warmUpMemory : memory;
+
+        for(qsizetype i = 0; i < messages.size(); i++) {
+            feed(decoder, messages[i]);
+
+            if(i % MEMORY_SAMPLE_INTERVAL == 0 || i == messages.size() - 1) {
+                maxCapacity = qMax(maxCapacity, decoder.inputCapacity());
+                maxMemory = qMax(maxMemory, residentMemory());
+            }
+        }
+    }
+
+    out << GAMES << " games of " << GAME_FRAMES << " frames, input ring " << warmUpCapacity << " bytes during the first "
+        << WARM_UP_GAMES << " games, " << capacity << " at most after them" << Qt::endl;
+
+    if(warmUpMemory >= 0) {
+        out << "resident memory " << warmUpMemory / 1024 << " KiB during the first " << WARM_UP_GAMES << " games, "
+            << memory / 1024 << " KiB at most after them" << Qt::endl;
+    }
+    else {
+        out << "resident memory is not measured on this platform" << Qt::endl;
+    }
+
+    if(capacity != warmUpCapacity) {
+        err << "The input ring grew by " << capacity - warmUpCapacity << " bytes over " << GAMES << " games" << Qt::endl;
+        return 1;
+    }
+
+    if(warmUpMemory >= 0 && memory - warmUpMemory > MEMORY_TOLERANCE) {
+        err << "The process memory grew by " << (memory - warmUpMemory) / 1024 << " KiB over " << GAMES << " games" << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int checkAllocations()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    EventDecoder decoder;
+    qint64 cursor = 0;
+    feed(decoder, R"({"type":"connect_reply","nick":"Check","version":"3.16.0","cursor":0,"next_cursor":0})");
+
+    // built up front, messages[i + 1] is commands[i]
+    QVector<QByteArray> commands = syntheticGame(GAME_FRAMES, 1);
+    QVector<QByteArray> messages = gameMessages(commands, cursor);
+
+    // from the frame start of the first frame after the warm up to the last frame, the game end releases the game's state
+    qsizetype first = 0, last = commands.size() - 1;
+    while(first < last && !(quint8(commands[first][0]) == EventDecoder::EVENT_FRAME_START
+                            && qFromBigEndian<qint32>(commands[first].constData() + 1) >= FIRST_FRAME + WARM_UP_FRAMES)) {
+        first++;
+    }
+
+    for(qsizetype i = 0; i <= first; i++) {
+        feed(decoder, messages[i]);
+    }
+
+    int frames = 0;
+    quint64 before = allocationCount.load();
+
+    for(qsizetype i = first; i < last; i++) {
+        feed(decoder, messages[i + 1]);
+        frames += quint8(commands[i][0]) == EventDecoder::EVENT_FRAME_BOOKEND ? 1 : 0;
+    }
+
+    quint64 allocations = allocationCount.load() - before;
+
+    for(qsizetype i = last + 1; i < messages.size(); i++) {
+        feed(decoder, messages[i]);
+    }
+
+    out << allocations << " allocations in " << frames << " frames after the first " << WARM_UP_FRAMES << " ("
+        << QString::number(qreal(allocations) / qMax(1, frames), 'f', 3) << " per frame)" << Qt::endl;
+
+    if(allocations > 0) {
+        err << "Decoding a running game allocates" << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
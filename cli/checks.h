@@ -0,0 +1,15 @@
+#ifndef CHECKS_H
+#define CHECKS_H
+
+// self checks of the decoder on synthetic games, need no replay.
+// results are printed to stdout, return the process exit code
+
+// 100 games of one live session through one EventDecoder. after the first 10 games, the capacity of
+// its input ring and the resident memory of the process must not grow any more
+int checkMemory();
+
+// allocations while a running game is decoded, after its first frames there must be none.
+// counts malloc() on glibc, which Qt's containers use, elsewhere only operator new
+int checkAllocations();
+
+#endif // CHECKS_H
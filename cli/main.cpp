@@ -0,0 +1,237 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include "benchmarks.h"
+#include "checks.h"
+#include "replayanalysis.h"
+#include "replayindex.h"
+
+// .slp files given directly and in the given directories and their subdirectories, sorted by path
+static QStringList findReplays(const QStringList &paths)
+{
+  QStringList files;
+
+  for(const QString &path : paths) {
+    QFileInfo info(path);
+
+    if(info.isDir()) {
+      QDirIterator it(path, { "*.slp" }, QDir::Files, QDirIterator::Subdirectories);
+      while(it.hasNext()) {
+        files << it.next();
+      }
+    }
+    else {
+      files << path;
+    }
+  }
+
+  files.sort();
+  return files;
+}
+
+// one row per replay with the connect codes and characters of all ports
+static void writeIndexCsv(QTextStream &out, const QVector<ReplayIndexEntry> &entries)
+{
+  out << "file,startAt,playedOn,lastFrame,version,stageId,matchId,gameNumber,tiebreakerNumber";
+  for(int i = 1; i <= NUM_PLAYERS; i++) {
+    out << ",p" << i << "Code,p" << i << "Name,p" << i << "CharId";
+  }
+  out << '\n';
+
+  for(const ReplayIndexEntry &entry : entries) {
+    if(!entry.valid) {
+      continue;
+    }
+
+    out << csvField(entry.fileName) << ',' << entry.startAt << ',' << csvField(entry.playedOn) << ','
+        << entry.lastFrame << ',' << csvField(entry.info.version) << ',' << entry.info.stageId << ','
+        << csvField(entry.info.matchId) << ',' << entry.info.gameNumber << ',' << entry.info.tiebreakerNumber;
+
+    for(const PlayerInfo &player : entry.players) {
+      bool empty = player.playerType == 3; // PlayerInformation::Empty
+      out << ',' << (empty ? QString() : csvField(player.slippiCode))
+          << ',' << (empty ? QString() : csvField(player.slippiName))
+          << ',' << (empty ? QString() : QString::number(player.charId));
+    }
+    out << '\n';
+  }
+
+  out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("SlippiStats");
+  QCoreApplication::setApplicationVersion("1.1");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Analyzes Slippi replays on all cores and writes the stats of every game as CSV.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("paths", "Replay files or directories, directories are searched recursively for .slp files.",
+                               "paths...");
+
+  QCommandLineOption outputOption({ "o", "output" }, "Write the CSV to <file> instead of stdout.", "file");
+  QCommandLineOption threadsOption({ "j", "threads" }, "Analyze <count> replays at once, one per core by default.", "count");
+  QCommandLineOption verboseOption("verbose", "Show the debug output of the decoder.");
+  QCommandLineOption benchBase64Option("bench-base64", "Measure the base64 decode of game event payloads against the QString and QByteArray::fromBase64() chain it replaced.");
+  QCommandLineOption benchDecodeOption("bench-decode", "Measure the decode cost per frame event of the replay in <paths>, one event at a time and columnar.");
+  QCommandLineOption benchStreamsOption("bench-streams", "Measure the throughput of 1 to --max-streams decoders running at once on the replay in <paths>.");
+  QCommandLineOption benchSeekOption("bench-seek", "Measure the size of the seek index of the replay in <paths> and the latency of seeks to random frames.");
+  QCommandLineOption checkMemoryOption("check-memory", "Check that the decoder's memory stays the same over 100 synthetic games.");
+  QCommandLineOption checkAllocationsOption("check-allocations", "Check that decoding a running synthetic game does not allocate memory.");
+  QCommandLineOption maxStreamsOption("max-streams", "Highest stream count for --bench-streams, at least 8 by default.", "count");
+  QCommandLineOption indexOption("index", "List the players, stage and match of every replay in the directory in <paths> "
+                                          "from the replay index instead of analyzing the games.");
+  QCommandLineOption indexFileOption("index-file", "Keep the replay index in <file> instead of the cache directory.", "file");
+  QCommandLineOption watchOption("watch", "With --index, keep running and update the index when replays change.");
+
+  parser.addOptions({ outputOption, threadsOption, verboseOption, benchBase64Option, benchDecodeOption, benchStreamsOption,
+                      benchSeekOption, checkMemoryOption, checkAllocationsOption, maxStreamsOption, indexOption,
+                      indexFileOption, watchOption });
+  parser.process(app);
+
+  QTextStream err(stderr);
+
+  if(!parser.isSet(verboseOption)) {
+    // e.g. every landing that is not a wavedash
+    QLoggingCategory::setFilterRules("*.debug=false");
+  }
+
+  // synthetic payloads and games, need no replay
+  if(parser.isSet(benchBase64Option)) {
+    return benchBase64();
+  }
+
+  if(parser.isSet(checkMemoryOption)) {
+    return checkMemory();
+  }
+
+  if(parser.isSet(checkAllocationsOption)) {
+    return checkAllocations();
+  }
+
+  QStringList paths = parser.positionalArguments();
+  if(paths.isEmpty()) {
+    parser.showHelp(1);
+  }
+
+  if(parser.isSet(benchDecodeOption)) {
+    return benchDecode(paths.first());
+  }
+
+  if(parser.isSet(benchStreamsOption)) {
+    int maxStreams = qMax(8, QThread::idealThreadCount());
+    if(parser.isSet(maxStreamsOption)) {
+      maxStreams = qMax(1, parser.value(maxStreamsOption).toInt());
+    }
+
+    return benchStreams(paths.first(), maxStreams);
+  }
+
+  if(parser.isSet(benchSeekOption)) {
+    return benchSeek(paths.first());
+  }
+
+  if(parser.isSet(indexOption)) {
+    ReplayIndex index;
+    QElapsedTimer timer;
+
+    QObject::connect(&index, &ReplayIndex::scanFinished, [&](int read, int removed) {
+      err << "Indexed " << index.entries().size() << " replays in " << timer.elapsed() << " ms, read " << read
+          << ", removed " << removed << " (" << index.indexFile() << ")" << Qt::endl;
+      timer.start();
+    });
+
+    timer.start();
+    if(!index.open(paths.first(), parser.value(indexFileOption))) {
+      return 1;
+    }
+
+    index.waitForScan();
+
+    QFile outputFile;
+    outputFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream out(&outputFile);
+    writeIndexCsv(out, index.entries());
+
+    if(!parser.isSet(watchOption)) {
+      return 0;
+    }
+
+    // the index reports every update from the file system watcher
+    return app.exec();
+  }
+
+  QStringList files = findReplays(paths);
+  if(files.isEmpty()) {
+    err << "No replays found." << Qt::endl;
+    return 1;
+  }
+
+  QFile outputFile;
+  if(parser.isSet(outputOption)) {
+    outputFile.setFileName(parser.value(outputOption));
+    if(!outputFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+      err << "Could not open " << outputFile.fileName() << ": " << outputFile.errorString() << Qt::endl;
+      return 1;
+    }
+  }
+  else {
+    outputFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+  }
+
+  QThreadPool pool;
+  if(parser.isSet(threadsOption)) {
+    pool.setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // one game per task, each writes only its own slot
+  QVector<GameSummary> games(files.size());
+  GameSummary *results = games.data();
+  for(int i = 0; i < files.size(); i++) {
+    pool.start([results, &files, i]() {
+      results[i] = analyzeReplay(files.at(i));
+    });
+  }
+
+  pool.waitForDone();
+  qint64 elapsed = timer.elapsed();
+
+  QTextStream out(&outputFile);
+  writeCsvHeader(out);
+
+  int failed = 0;
+  qint64 frames = 0, decodeTime = 0;
+  for(const GameSummary &game : std::as_const(games)) {
+    if(!game.error.isEmpty()) {
+      err << "Skipped " << game.fileName << ": " << game.error << Qt::endl;
+      failed++;
+      continue;
+    }
+
+    writeCsv(out, game);
+    frames += game.frames;
+    decodeTime += game.decodeTime;
+  }
+
+  out.flush();
+
+  err << "Analyzed " << games.size() - failed << " replays with " << frames << " frames in " << elapsed << " ms on "
+      << pool.maxThreadCount() << " threads (" << decodeTime / 1000 << " ms of decoding)" << Qt::endl;
+
+  return failed == games.size() ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+#include "replayanalysis.h"
+#include "eventdecoder.h"
+#include "slpfile.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMap>
+
+#include <limits>
+
+namespace {
+
+const quint8 PLAYER_TYPE_EMPTY = 3; // PlayerInformation::Empty
+
+// stats of all characters after one frame
+struct FrameSample {
+    PlayerStats stats[NUM_PLAYERS][2];
+};
+
+} // namespace
+
+QString csvField(const QString &value)
+{
+    if(!value.contains(',') && !value.contains('"') && !value.contains('\n')) {
+        return value;
+    }
+
+    return QChar('"') + QString(value).replace('"', "\"\"") + QChar('"');
+}
+
+void CharacterSummary::addFrame(const PlayerStats &stats)
+{
+    // set on the first landing frame only
+    if(stats.wavedashFrame > 0) {
+        wavedashes++;
+        wavedashFrameSum += stats.wavedashFrame;
+    }
+
+    // the l-cancel status of the post frame is only set on the landing frame
+    if(stats.lCancelState == 1) {
+        lCancels++;
+    }
+    else if(stats.lCancelState == 2) {
+        missedLCancels++;
+    }
+
+    // the presses count up during one cyclone and reset after it
+    if(stats.cycloneBPresses > previous.cycloneBPresses) {
+        if(previous.cycloneBPresses == 0) {
+            cyclones++;
+        }
+
+        cycloneBPresses += stats.cycloneBPresses - previous.cycloneBPresses;
+        maxCycloneBPresses = qMax<quint32>(maxCycloneBPresses, stats.cycloneBPresses);
+    }
+
+    // a combo is a string of at least two hits
+    if(stats.comboCount >= 2 && previous.comboCount < 2) {
+        combos++;
+    }
+    maxComboCount = qMax(maxComboCount, stats.comboCount);
+
+    previous = stats;
+}
+
+GameSummary analyzeReplay(const QString &fileName)
+{
+    GameSummary game;
+    game.fileName = fileName;
+
+    SlpFile file;
+    if(!file.open(fileName)) {
+        game.error = file.errorString();
+        return game;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // nothing reads the snapshots, this only publishes on game start
+    EventDecoder decoder;
+    decoder.setDeliveryMode(EventDecoder::TimeSlice, std::numeric_limits<int>::max());
+
+    // online replays contain the frames that were rolled back too,
+    // a frame is only counted once it can not be resent anymore
+    QMap<qint32, FrameSample> pending;
+    bool hasGameStart = false;
+
+    auto commitFrames = [&](qint32 lastFrame) {
+        auto it = pending.begin();
+        while(it != pending.end() && it.key() <= lastFrame) {
+            for(int i = 0; i < NUM_PLAYERS; i++) {
+                if(game.players[i].playerType == PLAYER_TYPE_EMPTY) {
+                    continue;
+                }
+
+                game.characters[i][0].addFrame(it->stats[i][0]);
+                if(game.hasFollower[i]) {
+                    game.characters[i][1].addFrame(it->stats[i][1]);
+                }
+            }
+
+            game.frames++;
+            it = pending.erase(it);
+        }
+    };
+
+    decoder.subscribe<GameState>([&](const GameState &state) {
+        hasGameStart = true;
+        game.info = state.info;
+
+        for(int i = 0; i < NUM_PLAYERS; i++) {
+            game.players[i] = state.players[i].info;
+        }
+    });
+
+    // once per frame, subscribed by reference so it is called without the std::function indirection
+    auto frameBookend = [&](const FrameBookendData &bookend) {
+        const GameState &state = decoder.gameState();
+
+        // a resent frame replaces the earlier sample, the frames after it are resent too
+        FrameSample &sample = pending[bookend.frameNumber];
+        for(int i = 0; i < NUM_PLAYERS; i++) {
+            const PlayerState &player = state.players[i];
+            sample.stats[i][0] = player.leader.stats;
+            sample.stats[i][1] = player.follower.stats;
+            game.hasFollower[i] |= player.hasFollower;
+        }
+
+        // before 3.7.0 every frame is final
+        bool hasFinalized = bookend.has(FrameBookendData::Field::LatestFinalizedFrame);
+        commitFrames(hasFinalized ? bookend.latestFinalizedFrame : bookend.frameNumber);
+    };
+    decoder.subscribeRef<FrameBookendData>(frameBookend);
+
+    decoder.subscribe<GameEndInfo>([&](const GameEndInfo &gameEnd) {
+        game.gameEnd = gameEnd;
+    });
+
+    QByteArrayView events = file.rawEvents();
+    qsizetype parsed = decoder.parseEvents(events);
+    commitFrames(std::numeric_limits<qint32>::max());
+
+    game.decodeTime = timer.nsecsElapsed() / 1000;
+
+    if(!hasGameStart) {
+        game.error = "No game start event";
+    }
+    else if(decoder.hasUnknownCommand()) {
+        qWarning().noquote() << fileName << "has an unknown event at offset" << parsed << "after" << game.frames
+                             << "frames, the rest of the replay is skipped";
+    }
+    else if(parsed < events.size()) {
+        qWarning().noquote() << fileName << "ends in an incomplete event after" << game.frames << "frames";
+    }
+
+    return game;
+}
+
+void writeCsvHeader(QTextStream &out)
+{
+    out << "file,version,frames,gameEndMethod,port,follower,charId,nameTag,slippiCode,"
+           "wavedashes,avgWavedashFrame,lCancels,missedLCancels,lCancelRate,"
+           "cyclones,cycloneBPresses,maxCycloneBPresses,combos,maxComboCount\n";
+}
+
+void writeCsv(QTextStream &out, const GameSummary &game)
+{
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        const PlayerInfo &player = game.players[i];
+        if(player.playerType == PLAYER_TYPE_EMPTY) {
+            continue;
+        }
+
+        for(int follower = 0; follower < (game.hasFollower[i] ? 2 : 1); follower++) {
+            const CharacterSummary &c = game.characters[i][follower];
+
+            quint32 landings = c.lCancels + c.missedLCancels;
+            qreal avgWavedashFrame = c.wavedashes > 0 ? qreal(c.wavedashFrameSum) / c.wavedashes : 0;
+            qreal lCancelRate = landings > 0 ? qreal(c.lCancels) / landings : 0;
+
+            out << csvField(game.fileName) << ','
+                << csvField(game.info.version) << ','
+                << game.frames << ','
+                << int(game.gameEnd.method) << ','
+                << i + 1 << ','
+                << follower << ','
+                << int(player.charId) << ','
+                << csvField(player.nameTag) << ','
+                << csvField(player.slippiCode) << ','
+                << c.wavedashes << ','
+                << QString::number(avgWavedashFrame, 'f', 2) << ','
+                << c.lCancels << ','
+                << c.missedLCancels << ','
+                << QString::number(lCancelRate, 'f', 3) << ','
+                << c.cyclones << ','
+                << c.cycloneBPresses << ','
+                << c.maxCycloneBPresses << ','
+                << c.combos << ','
+                << c.maxComboCount << '\n';
+        }
+    }
+}
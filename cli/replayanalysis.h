@@ -0,0 +1,49 @@
+#ifndef REPLAYANALYSIS_H
+#define REPLAYANALYSIS_H
+
+#include <QString>
+#include <QTextStream>
+
+#include "gamestate.h"
+
+// totals of one character over a whole game
+struct CharacterSummary {
+    quint32 wavedashes = 0;
+    quint64 wavedashFrameSum = 0;
+    quint32 lCancels = 0, missedLCancels = 0;
+    quint32 cyclones = 0, cycloneBPresses = 0, maxCycloneBPresses = 0;
+    quint32 combos = 0, maxComboCount = 0;
+
+    // stats of the previous frame, to count each cyclone and combo once
+    PlayerStats previous;
+
+    void addFrame(const PlayerStats &stats);
+};
+
+struct GameSummary {
+    QString fileName;
+    QString error; // empty if the replay was read
+
+    GameInfo info;
+    PlayerInfo players[NUM_PLAYERS];
+    CharacterSummary characters[NUM_PLAYERS][2]; // leader and follower
+    bool hasFollower[NUM_PLAYERS] = {};
+    GameEndInfo gameEnd;
+
+    // analyzed frames, replays before 3.0.0 have no frame bookends and no frame stats
+    qint32 frames = 0;
+    qint64 decodeTime = 0; // microseconds
+};
+
+// decodes one .slp file with its own EventDecoder and sums up the stats of every frame.
+// nothing is shared between calls, so any number of replays can be analyzed in parallel
+GameSummary analyzeReplay(const QString &fileName);
+
+// quoted if it contains a separator, quote or line break
+QString csvField(const QString &value);
+
+// one row per character
+void writeCsvHeader(QTextStream &out);
+void writeCsv(QTextStream &out, const GameSummary &game);
+
+#endif // REPLAYANALYSIS_H
@@ -33,11 +33,11 @@ App {
     property bool showCharSpecificOverlay: true
   }
 
-  DolphinConnection {
-    id: dolphin
+  DolphinConnectionManager {
+    id: dolphins
 
-    onConnectedChanged: if(!connected) parser.disconnnect()
-    onMessageReceived: (msg) => parser.parseSlippiMessage(msg)
+    // one entry per setup, each addConnection() without a parser gets its own SlippiEventParser
+    Component.onCompleted: addConnection("localhost", 51441, parser)
   }
 
   SlippiEventParser {
@@ -0,0 +1,232 @@
+#include "base64.h"
+#include "cpufeatures.h"
+
+#if defined(Q_PROCESSOR_X86)
+#include <immintrin.h>
+#define BASE64_X86
+#endif
+
+#if defined(BASE64_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BASE64_TARGET(arch) __attribute__((target(arch)))
+#else
+#define BASE64_TARGET(arch)
+#endif
+
+namespace {
+
+// maps ASCII to 6 bit values, 0xff for invalid characters
+struct DecodeTable {
+    quint8 values[256];
+
+    constexpr DecodeTable() : values() {
+        for(int i = 0; i < 256; i++) {
+            values[i] = 0xff;
+        }
+
+        const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for(int i = 0; i < 64; i++) {
+            values[quint8(alphabet[i])] = quint8(i);
+        }
+    }
+};
+
+constexpr DecodeTable decodeTable;
+
+qsizetype paddingLength(const char *in, qsizetype length) {
+    qsizetype padding = 0;
+    while(padding < 2 && length - padding > 0 && in[length - padding - 1] == '=') {
+        padding++;
+    }
+    return padding;
+}
+
+#if defined(BASE64_X86)
+
+// vectorized decoding after Wojciech Muła's and Alfred Klomp's work:
+// http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+
+BASE64_TARGET("ssse3")
+qsizetype decodeSsse3(const char *in, qsizetype length, char *out) {
+    const __m128i lutLo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+
+    const char *start = out;
+
+    // each block stores 16 bytes of which 12 are valid,
+    // only run while the rest of the input still produces at least 4 more bytes
+    while(length >= 24) {
+        __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+        __m128i loNibbles = _mm_and_si128(str, mask2F);
+        __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+
+        if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+            // invalid character or padding - let the scalar code handle it
+            break;
+        }
+
+        __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+        str = _mm_add_epi8(str, roll);
+
+        // pack 4x6 bits into 3 bytes per 32 bit lane
+        __m128i merged = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), merged);
+
+        in += 16;
+        length -= 16;
+        out += 12;
+    }
+
+    qsizetype tail = Base64::decodeScalar(in, length, out);
+    return tail < 0 ? -1 : (out - start) + tail;
+}
+
+BASE64_TARGET("avx2")
+qsizetype decodeAvx2(const char *in, qsizetype length, char *out) {
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+
+    const char *start = out;
+
+    // each block stores 32 bytes of which 24 are valid, see decodeSsse3()
+    while(length >= 48) {
+        __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+        __m256i loNibbles = _mm256_and_si256(str, mask2F);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+
+        if(!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+
+        __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        __m256i merged = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), merged);
+
+        in += 32;
+        length -= 32;
+        out += 24;
+    }
+
+    // the SSSE3 loop picks up the remaining 16 byte blocks
+    qsizetype tail = decodeSsse3(in, length, out);
+    return tail < 0 ? -1 : (out - start) + tail;
+}
+
+#endif // BASE64_X86
+
+using DecodeFunction = qsizetype (*)(const char *, qsizetype, char *);
+
+DecodeFunction selectDecoder() {
+#if defined(BASE64_X86)
+    switch(CpuFeatures::level()) {
+    case CpuFeatures::Level::Avx2:
+        return decodeAvx2;
+    case CpuFeatures::Level::Ssse3:
+        return decodeSsse3;
+    default:
+        break;
+    }
+#endif
+    return Base64::decodeScalar;
+}
+
+}
+
+qsizetype Base64::decodedSize(const char *in, qsizetype length)
+{
+    qsizetype chars = length - paddingLength(in, length);
+    return chars / 4 * 3 + qMax<qsizetype>(0, chars % 4 - 1);
+}
+
+qsizetype Base64::decode(const char *in, qsizetype length, char *out)
+{
+    static const DecodeFunction decoder = selectDecoder();
+
+    return decoder(in, length, out);
+}
+
+qsizetype Base64::decodeScalar(const char *in, qsizetype length, char *out)
+{
+    length -= paddingLength(in, length);
+
+    if(length % 4 == 1) {
+        return -1;
+    }
+
+    const quint8 *table = decodeTable.values;
+    const char *start = out;
+
+    for(; length >= 4; length -= 4, in += 4) {
+        quint8 a = table[quint8(in[0])], b = table[quint8(in[1])],
+            c = table[quint8(in[2])], d = table[quint8(in[3])];
+
+        if((a | b | c | d) & 0xc0) {
+            return -1;
+        }
+
+        quint32 bits = quint32(a) << 18 | quint32(b) << 12 | quint32(c) << 6 | d;
+        out[0] = char(bits >> 16);
+        out[1] = char(bits >> 8);
+        out[2] = char(bits);
+        out += 3;
+    }
+
+    if(length > 0) {
+        // 2 or 3 characters left from a padded or unpadded block
+        quint8 a = table[quint8(in[0])], b = table[quint8(in[1])],
+            c = length > 2 ? table[quint8(in[2])] : 0;
+
+        if((a | b | c) & 0xc0) {
+            return -1;
+        }
+
+        quint32 bits = quint32(a) << 18 | quint32(b) << 12 | quint32(c) << 6;
+        *out++ = char(bits >> 16);
+        if(length > 2) {
+            *out++ = char(bits >> 8);
+        }
+    }
+
+    return out - start;
+}
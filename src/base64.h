@@ -0,0 +1,23 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <QtGlobal>
+
+// base64 decoder for the game event payloads sent by Dolphin.
+// decodes into caller-provided memory so payloads can be written straight
+// into the parser's input buffer, uses SSSE3/AVX2 when the CPU supports it.
+namespace Base64 {
+
+// exact number of bytes decode() writes for well-formed input
+qsizetype decodedSize(const char *in, qsizetype length);
+
+// decodes length characters of standard base64 into out, which must have room for decodedSize() bytes.
+// returns the number of bytes written or -1 if the input is not valid base64.
+qsizetype decode(const char *in, qsizetype length, char *out);
+
+// portable implementation, also used for the tail of the vectorized versions
+qsizetype decodeScalar(const char *in, qsizetype length, char *out);
+
+}
+
+#endif // BASE64_H
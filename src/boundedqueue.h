@@ -0,0 +1,63 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+// lock-free single producer / single consumer queue with a fixed capacity.
+// push() fails instead of blocking or allocating when the consumer falls behind,
+// the producer counts the dropped entries and the fill level high-water mark.
+template<typename T, int Capacity>
+class BoundedQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // producer side
+    bool push(const T &value) {
+        unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        unsigned int size = tail - m_head.load(std::memory_order_acquire);
+
+        if(size >= unsigned(Capacity)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_items[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        if(int(size + 1) > m_highWaterMark.load(std::memory_order_relaxed)) {
+            m_highWaterMark.store(int(size + 1), std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // entries pushed and not yet popped, exact on the producer side
+    int size() const {
+        return int(m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire));
+    }
+
+    // consumer side, front() is only valid if isEmpty() returned false
+    bool isEmpty() const {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    const T &front() const { return m_items[m_head.load(std::memory_order_relaxed) & (Capacity - 1)]; }
+
+    void pop() {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // statistics, readable from both sides
+    int highWaterMark() const { return m_highWaterMark.load(std::memory_order_relaxed); }
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    T m_items[Capacity];
+    std::atomic<unsigned int> m_head = 0, m_tail = 0;
+    std::atomic<int> m_highWaterMark = 0;
+    std::atomic<quint64> m_dropped = 0;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,106 @@
+#include "bytering.h"
+
+#include <cstring>
+
+ByteRing::ByteRing(qsizetype capacity)
+{
+    reserve(capacity);
+}
+
+void ByteRing::reserve(qsizetype capacity)
+{
+    qsizetype newCapacity = qMax<qsizetype>(this->capacity(), 16);
+    while(newCapacity < capacity) {
+        newCapacity *= 2;
+    }
+
+    if(newCapacity == this->capacity()) {
+        return;
+    }
+
+    // move the content to the start of the new buffer
+    QByteArray buffer(newCapacity, Qt::Uninitialized);
+    qsizetype size = m_size;
+    read(buffer.data(), size);
+
+    m_buffer = buffer;
+    m_mask = newCapacity - 1;
+    m_head = 0;
+    m_size = size;
+}
+
+void ByteRing::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+bool ByteRing::write(const char *data, qsizetype length)
+{
+    if(length > freeSpace()) {
+        return false;
+    }
+
+    qsizetype tail = (m_head + m_size) & m_mask;
+    qsizetype first = qMin(length, capacity() - tail);
+
+    char *buffer = m_buffer.data();
+    std::memcpy(buffer + tail, data, first);
+    std::memcpy(buffer, data + first, length - first);
+
+    m_size += length;
+    return true;
+}
+
+char *ByteRing::contiguousWrite(qsizetype length)
+{
+    qsizetype tail = (m_head + m_size) & m_mask;
+
+    if(length > freeSpace() || tail + length > capacity()) {
+        return nullptr;
+    }
+
+    return m_buffer.data() + tail;
+}
+
+void ByteRing::commit(qsizetype length)
+{
+    m_size += length;
+}
+
+QByteArrayView ByteRing::peek(qsizetype length) const
+{
+    if(length > m_size || m_head + length > capacity()) {
+        return QByteArrayView();
+    }
+
+    return QByteArrayView(m_buffer.constData() + m_head, length);
+}
+
+qsizetype ByteRing::read(char *out, qsizetype length)
+{
+    length = qMin(length, m_size);
+
+    qsizetype first = qMin(length, capacity() - m_head);
+
+    const char *buffer = m_buffer.constData();
+    std::memcpy(out, buffer + m_head, first);
+    std::memcpy(out + first, buffer, length - first);
+
+    return skip(length);
+}
+
+qsizetype ByteRing::skip(qsizetype length)
+{
+    length = qMin(length, m_size);
+
+    m_head = (m_head + length) & m_mask;
+    m_size -= length;
+
+    if(m_size == 0) {
+        // keeps the next writes contiguous
+        m_head = 0;
+    }
+
+    return length;
+}
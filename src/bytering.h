@@ -0,0 +1,49 @@
+#ifndef BYTERING_H
+#define BYTERING_H
+
+#include <QByteArray>
+
+// fixed-capacity FIFO of bytes with separate read and write positions.
+// consumed bytes are reclaimed right away, so memory stays at the capacity
+// no matter how much data passes through. the capacity is a power of two.
+class ByteRing
+{
+public:
+    explicit ByteRing(qsizetype capacity = 0);
+
+    // grows to at least capacity bytes and keeps the content, never shrinks
+    void reserve(qsizetype capacity);
+
+    qsizetype capacity() const { return m_buffer.size(); }
+    qsizetype size() const { return m_size; }
+    qsizetype freeSpace() const { return capacity() - m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    void clear();
+
+    // returns false and writes nothing if there is not enough space
+    bool write(const char *data, qsizetype length);
+
+    // space for length bytes at the write position if they fit without wrapping, nullptr otherwise.
+    // the bytes are added with commit()
+    char *contiguousWrite(qsizetype length);
+    void commit(qsizetype length);
+
+    // length bytes at the read position if they are stored without wrapping, a null view otherwise.
+    // stays valid after skip() until the next write
+    QByteArrayView peek(qsizetype length) const;
+
+    // copy or drop up to length bytes from the read position, returns the number of bytes
+    qsizetype read(char *out, qsizetype length);
+    qsizetype skip(qsizetype length);
+
+    // byte at offset from the read position, offset must be less than size()
+    char at(qsizetype offset) const { return m_buffer.constData()[(m_head + offset) & m_mask]; }
+
+private:
+    QByteArray m_buffer;
+    qsizetype m_mask = 0;
+    qsizetype m_head = 0, m_size = 0;
+};
+
+#endif // BYTERING_H
@@ -0,0 +1,45 @@
+#include "cpufeatures.h"
+
+#if defined(Q_PROCESSOR_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+CpuFeatures::Level detectLevel() {
+#if defined(Q_PROCESSOR_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool ssse3 = info[2] & (1 << 9);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+
+    bool avx2 = false;
+    if(maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = info[1] & (1 << 5);
+    }
+#else
+    __builtin_cpu_init();
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    return avx2 ? CpuFeatures::Level::Avx2 : ssse3 ? CpuFeatures::Level::Ssse3 : CpuFeatures::Level::Scalar;
+#else
+    return CpuFeatures::Level::Scalar;
+#endif
+}
+
+}
+
+CpuFeatures::Level CpuFeatures::level()
+{
+    static const Level detected = detectLevel();
+
+    return detected;
+}
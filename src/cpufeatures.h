@@ -0,0 +1,16 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <QtGlobal>
+
+// instruction sets for the vectorized code paths, detected once at runtime
+namespace CpuFeatures {
+
+enum class Level { Scalar, Ssse3, Avx2 };
+
+// always Scalar on other architectures than x86
+Level level();
+
+}
+
+#endif // CPUFEATURES_H
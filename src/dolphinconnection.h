@@ -2,33 +2,64 @@
 #define DOLPHINCONNECTION_H
 
 #include <QObject>
-#include <QThread>
 
-#include <enet/enet.h>
+#include "eventparser.h"
+#include "streamworker.h"
 
+class DolphinConnectionManager;
+
+// one Dolphin endpoint served by a DolphinConnectionManager, with its own parser and game state
 class DolphinConnection : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(QString hostAddress READ hostAddress CONSTANT)
+    Q_PROPERTY(quint16 port READ port CONSTANT)
     Q_PROPERTY(bool connected MEMBER m_connected NOTIFY connectedChanged)
+    Q_PROPERTY(EventParser *parser READ parser WRITE setParser NOTIFY parserChanged)
+
+    // decoding statistics of this stream, busy time in ms
+    Q_PROPERTY(qreal busyTime READ busyTime NOTIFY streamStatsChanged)
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY streamStatsChanged)
+    Q_PROPERTY(int maxQueueDepth READ maxQueueDepth NOTIFY streamStatsChanged)
+
 public:
-    explicit DolphinConnection(QObject *parent = nullptr);
     ~DolphinConnection();
 
+    QString hostAddress() const;
+    quint16 port() const;
+    bool connected() const;
+
+    EventParser *parser() const;
+    void setParser(EventParser *parser);
+
+    qreal busyTime() const;
+    int queueDepth() const;
+    int maxQueueDepth() const;
+
 signals:
-    void messageReceived(const QVariantMap &message);
     void connectedChanged();
+    void parserChanged();
+    void streamStatsChanged();
+
+private:
+    friend class DolphinConnectionManager;
+
+    DolphinConnection(DolphinConnectionManager *manager, int id, const QString &hostAddress, quint16 port);
 
-private slots:
     void setConnected(bool newConnected);
 
-private:
-    friend class DolphinConnectionPrivate;
-    class DolphinConnectionPrivate *d;
+    DolphinConnectionManager *m_manager;
+    int m_id;
+
+    QString m_hostAddress;
+    quint16 m_port;
+    bool m_connected = false;
+
+    EventParser *m_parser = nullptr;
+    QMetaObject::Connection m_parserDestroyedConnection;
 
-    QThread m_connectionThread;
-    quint16 m_port = 51441;
-    QString m_hostAddress = "localhost";
-    bool m_connected;
+    // shared with the connection thread and the stream's worker
+    QSharedPointer<StreamStats> m_stats;
 };
 
 #endif // DOLPHINCONNECTION_H
@@ -0,0 +1,738 @@
+#include "dolphinconnectionmanager.h"
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <enet/enet.h>
+
+// runs in the connection thread and owns the ENet host shared by all endpoints
+class DolphinConnectionManagerPrivate : public QObject {
+    Q_OBJECT
+
+public:
+    DolphinConnectionManagerPrivate(DolphinConnectionManager *manager);
+    ~DolphinConnectionManagerPrivate();
+
+    enum State {
+        Connecting, // ENet handshake in progress
+        Connected,  // handshake done, receiving game events
+        Waiting     // waiting for the next connection attempt
+    };
+
+    struct Endpoint {
+        int id;
+        ENetAddress address;
+        ENetPeer *peer = nullptr;
+        State state = Waiting;
+        int failedAttempts = 0;
+        int receivedEvents = 0;
+
+        QSharedPointer<EventDecoder> decoder;
+        QSharedPointer<StreamStats> stats;
+
+        // only set in worker pool mode
+        QSharedPointer<StreamWorker> worker;
+
+        QTimer *connectTimer = nullptr;
+        QTimer *reconnectTimer = nullptr;
+    };
+
+public slots:
+    void addEndpoint(int id, const QString &hostname, quint16 port, QSharedPointer<StreamStats> stats);
+    void removeEndpoint(int id);
+    void setDecoder(int id, QSharedPointer<EventDecoder> decoder);
+    void setWorkerThreads(int workerThreads);
+    void stop();
+
+    // drains all pending ENet events of all endpoints, called whenever the socket becomes readable
+    void service();
+
+private:
+    Endpoint *endpoint(int id) const;
+
+    void startConnect(Endpoint *endpoint);
+    void connectTimedOut(Endpoint *endpoint);
+    void scheduleReconnect(Endpoint *endpoint);
+    void resetPeer(Endpoint *endpoint);
+    void setState(Endpoint *endpoint, State state);
+    void setConnected(Endpoint *endpoint, bool connected);
+    void updateWorker(Endpoint *endpoint);
+
+    // the socket is only watched while any endpoint connects or is connected
+    void updateServicing();
+
+    void handleEvent(const ENetEvent &event);
+    void updateServiceStats(int drainedEvents);
+
+    // asks Dolphin to (re)send the game events starting at cursor
+    bool sendConnectRequest(Endpoint *endpoint, qint64 cursor);
+
+    // reconnect delays: doubled on every failed attempt up to the maximum, +-25% jitter
+    static const int CONNECT_TIMEOUT = 5000;
+    static const int RECONNECT_DELAY_MIN = 100;
+    static const int RECONNECT_DELAY_MAX = 2000;
+
+    DolphinConnectionManager *m_manager;
+    ENetHost *m_client;
+    QList<Endpoint *> m_endpoints;
+    QThreadPool *m_pool = nullptr;
+
+    QSocketNotifier *m_socketNotifier = nullptr;
+    QTimer *m_serviceTimer = nullptr;
+};
+
+#include "dolphinconnectionmanager.moc"
+
+DolphinConnectionManager::DolphinConnectionManager(QObject *parent)
+    : QAbstractListModel{parent}, d(new DolphinConnectionManagerPrivate(this))
+{
+    d->moveToThread(&m_connectionThread);
+    m_connectionThread.start();
+}
+
+DolphinConnectionManager::~DolphinConnectionManager()
+{
+    QMetaObject::invokeMethod(d, "stop", Qt::BlockingQueuedConnection);
+
+    m_connectionThread.quit();
+    m_connectionThread.wait();
+
+    delete d;
+}
+
+int DolphinConnectionManager::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_connections.size();
+}
+
+QVariant DolphinConnectionManager::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_connections.size()) {
+        return QVariant();
+    }
+
+    DolphinConnection *connection = m_connections[index.row()];
+
+    switch(role) {
+    case ConnectionRole:
+        return QVariant::fromValue(connection);
+    case ParserRole:
+        return QVariant::fromValue(connection->parser());
+    case Qt::DisplayRole:
+    case HostAddressRole:
+        return connection->hostAddress();
+    case PortRole:
+        return connection->port();
+    case ConnectedRole:
+        return connection->connected();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> DolphinConnectionManager::roleNames() const
+{
+    return {
+        { ConnectionRole, "connection" },
+        { ParserRole, "parser" },
+        { HostAddressRole, "hostAddress" },
+        { PortRole, "port" },
+        { ConnectedRole, "connected" }
+    };
+}
+
+int DolphinConnectionManager::count() const
+{
+    return m_connections.size();
+}
+
+DolphinConnection *DolphinConnectionManager::addConnection(const QString &hostAddress, quint16 port, EventParser *parser)
+{
+    if(m_connections.size() >= MAX_CONNECTIONS) {
+        qWarning() << "DolphinConnectionManager: cannot serve more than" << MAX_CONNECTIONS << "connections.";
+        return nullptr;
+    }
+
+    int id = m_nextId++;
+    DolphinConnection *connection = new DolphinConnection(this, id, hostAddress, port);
+
+    connect(connection, &DolphinConnection::connectedChanged, this, [this, connection]() {
+        connectionChanged(connection);
+    });
+    connect(connection, &DolphinConnection::parserChanged, this, [this, connection]() {
+        connectionChanged(connection);
+    });
+
+    beginInsertRows(QModelIndex(), m_connections.size(), m_connections.size());
+    m_connections.append(connection);
+    endInsertRows();
+
+    QMetaObject::invokeMethod(d, [d = d, id, hostAddress, port, stats = connection->m_stats]() {
+        d->addEndpoint(id, hostAddress, port, stats);
+    });
+
+    if(!parser) {
+        // owned by the connection, so every setup gets its own game state
+        parser = new EventParser(connection);
+    }
+    connection->setParser(parser);
+
+    emit countChanged();
+
+    return connection;
+}
+
+void DolphinConnectionManager::removeConnection(int index)
+{
+    if(index < 0 || index >= m_connections.size()) {
+        return;
+    }
+
+    DolphinConnection *connection = m_connections[index];
+    QMetaObject::invokeMethod(d, "removeEndpoint", Q_ARG(int, connection->m_id));
+
+    beginRemoveRows(QModelIndex(), index, index);
+    m_connections.removeAt(index);
+    endRemoveRows();
+
+    connection->deleteLater();
+
+    emit countChanged();
+}
+
+DolphinConnection *DolphinConnectionManager::connectionAt(int index) const
+{
+    return index >= 0 && index < m_connections.size() ? m_connections[index] : nullptr;
+}
+
+int DolphinConnectionManager::workerThreads() const
+{
+    return m_workerThreads;
+}
+
+void DolphinConnectionManager::setWorkerThreads(int workerThreads)
+{
+    workerThreads = qMax(0, workerThreads);
+    if(m_workerThreads == workerThreads)
+        return;
+
+    m_workerThreads = workerThreads;
+    QMetaObject::invokeMethod(d, "setWorkerThreads", Q_ARG(int, workerThreads));
+
+    emit workerThreadsChanged();
+}
+
+int DolphinConnectionManager::wakeups() const
+{
+    return m_wakeups;
+}
+
+int DolphinConnectionManager::lastEventsPerWakeup() const
+{
+    return m_lastEventsPerWakeup;
+}
+
+int DolphinConnectionManager::maxEventsPerWakeup() const
+{
+    return m_maxEventsPerWakeup;
+}
+
+qreal DolphinConnectionManager::averageEventsPerWakeup() const
+{
+    int wakeups = m_wakeups;
+    return wakeups > 0 ? qreal(m_drainedEvents) / wakeups : 0;
+}
+
+void DolphinConnectionManager::setDecoder(int id, QSharedPointer<EventDecoder> decoder)
+{
+    if(decoder) {
+        if(decoder->thread() == QThread::currentThread()) {
+            decoder->moveToThread(&m_connectionThread);
+        }
+        else if(decoder->thread() != &m_connectionThread) {
+            qWarning() << "DolphinConnectionManager: decoder already used by another thread.";
+        }
+    }
+
+    // the decoder is shared, so it stays valid in the connection thread until replaced
+    QMetaObject::invokeMethod(d, [d = d, id, decoder]() {
+        d->setDecoder(id, decoder);
+    });
+}
+
+void DolphinConnectionManager::setConnected(int id, bool connected)
+{
+    int index = indexOf(id);
+    if(index >= 0) {
+        m_connections[index]->setConnected(connected);
+    }
+}
+
+int DolphinConnectionManager::indexOf(int id) const
+{
+    for(int i = 0; i < m_connections.size(); i++) {
+        if(m_connections[i]->m_id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void DolphinConnectionManager::connectionChanged(DolphinConnection *connection)
+{
+    int row = m_connections.indexOf(connection);
+    if(row >= 0) {
+        emit dataChanged(index(row), index(row));
+    }
+}
+
+DolphinConnectionManagerPrivate::DolphinConnectionManagerPrivate(DolphinConnectionManager *manager) : m_manager(manager) {
+    m_client = enet_host_create(nullptr, DolphinConnectionManager::MAX_CONNECTIONS, 3, 0, 0);
+
+    if (m_client == nullptr)
+    {
+        qWarning() << "An error occurred while trying to create an ENet client host.";
+        return;
+    }
+}
+
+DolphinConnectionManagerPrivate::~DolphinConnectionManagerPrivate() {
+    if(m_client) {
+        enet_host_destroy(m_client);
+        m_client = nullptr;
+    }
+}
+
+void DolphinConnectionManagerPrivate::addEndpoint(int id, const QString &hostname, quint16 port, QSharedPointer<StreamStats> stats) {
+    if(!m_client) {
+        return;
+    }
+
+    if(!m_socketNotifier) {
+        // created here so they live in the connection thread
+        m_socketNotifier = new QSocketNotifier(qintptr(m_client->socket), QSocketNotifier::Read, this);
+        m_socketNotifier->setEnabled(false);
+        QObject::connect(m_socketNotifier, &QSocketNotifier::activated, this, &DolphinConnectionManagerPrivate::service);
+
+        // ENet also needs to be serviced without incoming data for pings, resends and timeouts
+        m_serviceTimer = new QTimer(this);
+        m_serviceTimer->setInterval(ENET_PEER_PING_INTERVAL);
+        QObject::connect(m_serviceTimer, &QTimer::timeout, this, &DolphinConnectionManagerPrivate::service);
+    }
+
+    Endpoint *endpoint = new Endpoint;
+    endpoint->id = id;
+    endpoint->stats = stats;
+
+    enet_address_set_host(&endpoint->address, hostname.toLocal8Bit().data());
+    endpoint->address.port = port;
+
+    endpoint->connectTimer = new QTimer(this);
+    endpoint->connectTimer->setSingleShot(true);
+    endpoint->connectTimer->setInterval(CONNECT_TIMEOUT);
+    QObject::connect(endpoint->connectTimer, &QTimer::timeout, this, [this, endpoint]() {
+        connectTimedOut(endpoint);
+    });
+
+    endpoint->reconnectTimer = new QTimer(this);
+    endpoint->reconnectTimer->setSingleShot(true);
+    QObject::connect(endpoint->reconnectTimer, &QTimer::timeout, this, [this, endpoint]() {
+        startConnect(endpoint);
+    });
+
+    m_endpoints.append(endpoint);
+
+    startConnect(endpoint);
+}
+
+void DolphinConnectionManagerPrivate::removeEndpoint(int id) {
+    Endpoint *endpoint = this->endpoint(id);
+    if(!endpoint) {
+        return;
+    }
+
+    if(endpoint->peer) {
+        // tell Dolphin right away, the peer is released without waiting for an acknowledgement
+        enet_peer_disconnect_now(endpoint->peer, 0);
+    }
+
+    // the peer slot must not point to the deleted endpoint, see handleEvent()
+    resetPeer(endpoint);
+
+    // a removed stream is not resumed, its state and cursors must not outlive it
+    if(endpoint->worker) {
+        endpoint->worker->post([decoder = endpoint->decoder]() {
+            decoder->resetConnection();
+            decoder->flush();
+        });
+    }
+    else if(endpoint->decoder) {
+        endpoint->decoder->resetConnection();
+        endpoint->decoder->flush();
+    }
+
+    m_endpoints.removeOne(endpoint);
+
+    delete endpoint->connectTimer;
+    delete endpoint->reconnectTimer;
+    delete endpoint;
+
+    updateServicing();
+}
+
+void DolphinConnectionManagerPrivate::setDecoder(int id, QSharedPointer<EventDecoder> decoder) {
+    if(Endpoint *endpoint = this->endpoint(id)) {
+        endpoint->decoder = decoder;
+        updateWorker(endpoint);
+    }
+}
+
+void DolphinConnectionManagerPrivate::setWorkerThreads(int workerThreads) {
+    if(workerThreads > 0) {
+        if(m_pool) {
+            m_pool->setMaxThreadCount(workerThreads);
+            return;
+        }
+
+        m_pool = new QThreadPool(this);
+        m_pool->setMaxThreadCount(workerThreads);
+    }
+    else if(m_pool) {
+        // finish all queued work before decoding in this thread again
+        for(Endpoint *endpoint : std::as_const(m_endpoints)) {
+            endpoint->worker.reset();
+        }
+
+        m_pool->waitForDone();
+        delete m_pool;
+        m_pool = nullptr;
+    }
+    else {
+        return;
+    }
+
+    for(Endpoint *endpoint : std::as_const(m_endpoints)) {
+        updateWorker(endpoint);
+    }
+}
+
+void DolphinConnectionManagerPrivate::stop() {
+    for(Endpoint *endpoint : std::as_const(m_endpoints)) {
+        resetPeer(endpoint);
+        delete endpoint->connectTimer;
+        delete endpoint->reconnectTimer;
+    }
+
+    qDeleteAll(m_endpoints);
+    m_endpoints.clear();
+
+    if(m_pool) {
+        m_pool->waitForDone();
+    }
+
+    delete m_socketNotifier;
+    m_socketNotifier = nullptr;
+
+    delete m_serviceTimer;
+    m_serviceTimer = nullptr;
+}
+
+void DolphinConnectionManagerPrivate::service() {
+    if(!m_client) {
+        return;
+    }
+
+    ENetEvent event;
+    int drainedEvents = 0;
+
+    // one service call reads everything queued on the socket for all peers,
+    // the remaining events it produced are then dispatched without further socket I/O
+    int ret = enet_host_service(m_client, &event, 0);
+
+    while(ret > 0) {
+        drainedEvents++;
+        handleEvent(event);
+
+        ret = enet_host_check_events(m_client, &event);
+    }
+
+    // send acknowledgements for everything received
+    enet_host_flush(m_client);
+
+    for(Endpoint *endpoint : std::as_const(m_endpoints)) {
+        if(endpoint->receivedEvents == 0 || !endpoint->decoder) {
+            endpoint->receivedEvents = 0;
+            continue;
+        }
+
+        endpoint->receivedEvents = 0;
+
+        // hand the results to the GUI as configured by the delivery mode,
+        // workers flush after draining their queue themselves
+        if(!endpoint->worker) {
+            QElapsedTimer timer;
+            timer.start();
+
+            endpoint->decoder->flush();
+
+            endpoint->stats->busyTime += timer.nsecsElapsed() / 1000;
+        }
+
+        // a resend requested by a worker is picked up with the next service call
+        qint64 resendCursor;
+        if(endpoint->state == Connected && endpoint->decoder->takeResendRequest(resendCursor)) {
+            sendConnectRequest(endpoint, resendCursor);
+        }
+    }
+
+    updateServiceStats(drainedEvents);
+}
+
+DolphinConnectionManagerPrivate::Endpoint *DolphinConnectionManagerPrivate::endpoint(int id) const {
+    for(Endpoint *endpoint : m_endpoints) {
+        if(endpoint->id == id) {
+            return endpoint;
+        }
+    }
+    return nullptr;
+}
+
+void DolphinConnectionManagerPrivate::startConnect(Endpoint *endpoint) {
+    resetPeer(endpoint);
+
+    // ENet sends and resends the connect command from service(), nothing here blocks
+    endpoint->peer = enet_host_connect(m_client, &endpoint->address, 3, 0);
+
+    if (endpoint->peer == nullptr)
+    {
+        qWarning() << "No available peers for initiating an ENet connection.";
+        scheduleReconnect(endpoint);
+        return;
+    }
+
+    // routes the events of this peer back to the endpoint
+    endpoint->peer->data = endpoint;
+
+    setState(endpoint, Connecting);
+    enet_host_flush(m_client);
+    endpoint->connectTimer->start();
+}
+
+void DolphinConnectionManagerPrivate::connectTimedOut(Endpoint *endpoint) {
+    if(endpoint->state != Connecting) {
+        return;
+    }
+
+    qDebug() << "Not connected to Dolphin" << endpoint->id << "after" << CONNECT_TIMEOUT << "ms. Try again.";
+
+    // drop the half open peer without waiting for a disconnect acknowledgement
+    resetPeer(endpoint);
+    scheduleReconnect(endpoint);
+}
+
+void DolphinConnectionManagerPrivate::scheduleReconnect(Endpoint *endpoint) {
+    // nothing to service for this endpoint until the next attempt
+    setState(endpoint, Waiting);
+
+    int delay = qMin(RECONNECT_DELAY_MAX, RECONNECT_DELAY_MIN << qMin(endpoint->failedAttempts, 16));
+    delay += QRandomGenerator::global()->bounded(delay / 2 + 1) - delay / 4;
+    endpoint->failedAttempts++;
+
+    endpoint->reconnectTimer->start(delay);
+}
+
+void DolphinConnectionManagerPrivate::resetPeer(Endpoint *endpoint) {
+    if(endpoint->peer) {
+        endpoint->peer->data = nullptr;
+        enet_peer_reset(endpoint->peer);
+        endpoint->peer = nullptr;
+    }
+}
+
+void DolphinConnectionManagerPrivate::setState(Endpoint *endpoint, State state) {
+    endpoint->state = state;
+
+    if(state != Connecting) {
+        endpoint->connectTimer->stop();
+    }
+
+    updateServicing();
+}
+
+void DolphinConnectionManagerPrivate::setConnected(Endpoint *endpoint, bool connected) {
+    DolphinConnectionManager *manager = m_manager;
+    int id = endpoint->id;
+
+    QMetaObject::invokeMethod(m_manager, [manager, id, connected]() {
+        manager->setConnected(id, connected);
+    }, Qt::QueuedConnection);
+}
+
+void DolphinConnectionManagerPrivate::updateWorker(Endpoint *endpoint) {
+    if(m_pool && endpoint->decoder) {
+        endpoint->worker.reset(new StreamWorker(endpoint->decoder, endpoint->stats, m_pool));
+
+        // the delayed flush of the delivery modes also runs as a task, never concurrently with decoding
+        QWeakPointer<StreamWorker> weakWorker = endpoint->worker;
+        endpoint->decoder->setExecutor([weakWorker](std::function<void()> function) {
+            if(QSharedPointer<StreamWorker> worker = weakWorker.toStrongRef()) {
+                worker->post(std::move(function));
+            }
+        });
+    }
+    else {
+        endpoint->worker.reset();
+
+        if(endpoint->decoder) {
+            endpoint->decoder->setExecutor(nullptr);
+        }
+    }
+}
+
+void DolphinConnectionManagerPrivate::updateServicing() {
+    if(!m_socketNotifier) {
+        return;
+    }
+
+    bool active = false;
+    for(Endpoint *endpoint : std::as_const(m_endpoints)) {
+        active = active || endpoint->state != Waiting;
+    }
+
+    m_socketNotifier->setEnabled(active);
+
+    if(!active) {
+        m_serviceTimer->stop();
+    }
+    else if(!m_serviceTimer->isActive()) {
+        m_serviceTimer->start();
+    }
+}
+
+void DolphinConnectionManagerPrivate::handleEvent(const ENetEvent &event) {
+    Endpoint *endpoint = static_cast<Endpoint *>(event.peer->data);
+
+    if(!endpoint) {
+        // peer of a removed endpoint
+        if(event.type == ENET_EVENT_TYPE_RECEIVE) {
+            enet_packet_destroy(event.packet);
+        }
+        return;
+    }
+
+    switch(event.type) {
+    case ENET_EVENT_TYPE_CONNECT:
+        qDebug() << "Connected to Dolphin" << endpoint->id << "channels:" << event.peer->channelCount;
+
+        // continue after the last event decoded before a disconnect, 0 for a fresh connection
+        if(!sendConnectRequest(endpoint, endpoint->decoder ? endpoint->decoder->resumeCursor() : 0)) {
+            resetPeer(endpoint);
+            scheduleReconnect(endpoint);
+            break;
+        }
+
+        endpoint->failedAttempts = 0;
+        setState(endpoint, Connected);
+        setConnected(endpoint, true);
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        // the peer is released by ENet after this event
+        event.peer->data = nullptr;
+        endpoint->peer = nullptr;
+
+        if(endpoint->state == Connecting) {
+            qDebug() << "Could not connect to Dolphin" << endpoint->id;
+            scheduleReconnect(endpoint);
+            break;
+        }
+
+        qDebug() << "Disconnected from Dolphin" << endpoint->id;
+
+        if(endpoint->worker) {
+            endpoint->worker->post([decoder = endpoint->decoder]() {
+                decoder->connectionLost();
+            });
+        }
+        else if(endpoint->decoder) {
+            endpoint->decoder->connectionLost();
+            endpoint->receivedEvents++;
+        }
+
+        setConnected(endpoint, false);
+
+        // Dolphin is probably still there, try again right away
+        endpoint->failedAttempts = 0;
+        scheduleReconnect(endpoint);
+        break;
+    case ENET_EVENT_TYPE_RECEIVE:
+        endpoint->receivedEvents++;
+
+        if(endpoint->worker) {
+            // the worker decodes from the packet memory and destroys it afterwards
+            endpoint->worker->postMessage(QByteArrayView((const char*)event.packet->data, qsizetype(event.packet->dataLength)),
+                                          [](void *packet) { enet_packet_destroy(static_cast<ENetPacket *>(packet)); },
+                                          event.packet);
+            break;
+        }
+
+        // decode straight from the packet memory
+        if(endpoint->decoder) {
+            QElapsedTimer timer;
+            timer.start();
+
+            endpoint->decoder->parseMessageData(QByteArrayView((const char*)event.packet->data, qsizetype(event.packet->dataLength)));
+
+            endpoint->stats->busyTime += timer.nsecsElapsed() / 1000;
+            endpoint->stats->packets++;
+        }
+
+        enet_packet_destroy(event.packet);
+        break;
+    default:
+        qDebug() << "Unknown event:" << event.type;
+        break;
+    }
+}
+
+bool DolphinConnectionManagerPrivate::sendConnectRequest(Endpoint *endpoint, qint64 cursor) {
+    QByteArray data = "{\"type\": \"connect_request\", \"cursor\": " + QByteArray::number(cursor) + "}";
+
+    qDebug().noquote() << "Send to" << endpoint->id << ":" << data;
+
+    ENetPacket * packet = enet_packet_create(data.constData(), data.size(), ENET_PACKET_FLAG_RELIABLE);
+
+    if(enet_peer_send(endpoint->peer, 0, packet) != 0) {
+        qWarning() << "Could not send connect request";
+        enet_packet_destroy(packet);
+        return false;
+    }
+
+    enet_host_flush(m_client);
+    return true;
+}
+
+void DolphinConnectionManagerPrivate::updateServiceStats(int drainedEvents) {
+    m_manager->m_wakeups++;
+    m_manager->m_drainedEvents += drainedEvents;
+    m_manager->m_lastEventsPerWakeup = drainedEvents;
+
+    if(drainedEvents > m_manager->m_maxEventsPerWakeup) {
+        m_manager->m_maxEventsPerWakeup = drainedEvents;
+    }
+
+    // notify at most once per GUI event loop iteration
+    if(!m_manager->m_serviceStatsPending.exchange(true)) {
+        DolphinConnectionManager *manager = m_manager;
+        QMetaObject::invokeMethod(m_manager, [manager]() {
+            manager->m_serviceStatsPending = false;
+            emit manager->serviceStatsChanged();
+
+            for(DolphinConnection *connection : std::as_const(manager->m_connections)) {
+                emit connection->streamStatsChanged();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
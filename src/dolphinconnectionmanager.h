@@ -0,0 +1,94 @@
+#ifndef DOLPHINCONNECTIONMANAGER_H
+#define DOLPHINCONNECTIONMANAGER_H
+
+#include <QAbstractListModel>
+#include <QThread>
+
+#include <atomic>
+
+#include "dolphinconnection.h"
+
+// serves any number of Dolphin endpoints from one ENet host and one connection thread.
+// each row is a DolphinConnection with its own parser, so one process can drive the overlays of several setups.
+class DolphinConnectionManager : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+    // 0 decodes all streams in the connection thread,
+    // otherwise each stream is decoded by tasks on a pool with this many threads
+    Q_PROPERTY(int workerThreads READ workerThreads WRITE setWorkerThreads NOTIFY workerThreadsChanged)
+
+    // ENet service loop statistics, shared by all connections
+    Q_PROPERTY(int wakeups READ wakeups NOTIFY serviceStatsChanged)
+    Q_PROPERTY(int lastEventsPerWakeup READ lastEventsPerWakeup NOTIFY serviceStatsChanged)
+    Q_PROPERTY(int maxEventsPerWakeup READ maxEventsPerWakeup NOTIFY serviceStatsChanged)
+    Q_PROPERTY(qreal averageEventsPerWakeup READ averageEventsPerWakeup NOTIFY serviceStatsChanged)
+
+public:
+    enum Roles {
+        ConnectionRole = Qt::UserRole + 1,
+        ParserRole,
+        HostAddressRole,
+        PortRole,
+        ConnectedRole
+    };
+
+    // maximum number of endpoints, ENet allocates all peers up front
+    static const int MAX_CONNECTIONS = 16;
+
+    explicit DolphinConnectionManager(QObject *parent = nullptr);
+    ~DolphinConnectionManager();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+    int workerThreads() const;
+    void setWorkerThreads(int workerThreads);
+
+    // creates a parser for the connection if none is given
+    Q_INVOKABLE DolphinConnection *addConnection(const QString &hostAddress = "localhost", quint16 port = 51441,
+                                                 EventParser *parser = nullptr);
+    Q_INVOKABLE void removeConnection(int index);
+    Q_INVOKABLE DolphinConnection *connectionAt(int index) const;
+
+    int wakeups() const;
+    int lastEventsPerWakeup() const;
+    int maxEventsPerWakeup() const;
+    qreal averageEventsPerWakeup() const;
+
+signals:
+    void countChanged();
+    void workerThreadsChanged();
+    void serviceStatsChanged();
+
+private:
+    friend class DolphinConnection;
+    friend class DolphinConnectionManagerPrivate;
+
+    // called from DolphinConnection, hands the decoder to the connection thread
+    void setDecoder(int id, QSharedPointer<EventDecoder> decoder);
+
+    // called from the connection thread through queued invocations
+    void setConnected(int id, bool connected);
+
+    int indexOf(int id) const;
+    void connectionChanged(DolphinConnection *connection);
+
+    class DolphinConnectionManagerPrivate *d;
+    QThread m_connectionThread;
+
+    QList<DolphinConnection *> m_connections;
+    int m_nextId = 0;
+    int m_workerThreads = 0;
+
+    // written from the connection thread
+    std::atomic<int> m_wakeups = 0, m_lastEventsPerWakeup = 0, m_maxEventsPerWakeup = 0;
+    std::atomic<qint64> m_drainedEvents = 0;
+    std::atomic<bool> m_serviceStatsPending = false;
+};
+
+#endif // DOLPHINCONNECTIONMANAGER_H
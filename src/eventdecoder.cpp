@@ -0,0 +1,1053 @@
+#include "eventdecoder.h"
+#include "base64.h"
+#include "slippieventlayout.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QThread>
+#include <QtEndian>
+#include <QTextCodec>
+
+#include <algorithm>
+
+EventDecoder::EventDecoder(QObject *parent) : QObject{parent},
+    m_flushTimer(this)
+{
+    // flushes whatever is left when no more messages arrive
+    m_flushTimer.setSingleShot(true);
+    connect(&m_flushTimer, &QTimer::timeout, this, &EventDecoder::flushTimeout);
+
+    // add default values. current version of mainline beta only sends sizes for the first game of the session.
+    m_payloadSizes[0x10] = 516;
+    m_payloadSizes[0x36] = 760;
+    m_payloadSizes[0x37] = 64;
+    m_payloadSizes[0x38] = 84;
+    m_payloadSizes[0x39] = 6;
+    m_payloadSizes[0x3a] = 12;
+    m_payloadSizes[0x3b] = 44;
+    m_payloadSizes[0x3c] = 8;
+    m_payloadSizes[0x3d] = 54480;
+
+    m_payloadSizes[0x45] = 36; // some unknown command it sends if connecting to a running game
+
+    updateInputCapacity();
+    updateFrameDecoders();
+    resetGameState();
+}
+
+void EventDecoder::parseMessageData(QByteArrayView data)
+{
+    SlippiMessage message;
+
+    if(!message.parse(data)) {
+        qWarning() << "EventDecoder: Could not parse message" << data.first(qMin<qsizetype>(data.size(), 100));
+        return;
+    }
+
+    parseMessage(message);
+}
+
+void EventDecoder::setDeliveryMode(DeliveryMode mode, int flushInterval)
+{
+    m_deliveryMode = mode;
+    m_flushInterval = qMax(1, flushInterval);
+}
+
+void EventDecoder::parseMessage(const SlippiMessage &message)
+{
+    if(m_catchingUp && m_lastMessageTimer.isValid() && m_lastMessageTimer.elapsed() >= catchUpGap()) {
+        // the stream paused, the backlog is done and this message is live
+        finishCatchUp();
+    }
+    m_lastMessageTimer.start();
+
+    if(m_pendingMessages++ == 0) {
+        m_pendingSince.start();
+    }
+
+    switch(message.type) {
+    case SlippiMessage::ConnectReply:
+        m_nick = message.decodeString(message.nick);
+        m_version = message.decodeString(message.version);
+        m_connected = true;
+
+        // replies to resend requests are ignored, recoverGap() resynchronizes if the events do not arrive
+        if(!m_awaitingResend) {
+            bool resumed = m_nextCursor > 0 && message.cursor == m_nextCursor;
+
+            // Dolphin starts at a different cursor if it restarted or no longer buffers the requested events
+            if(m_nextCursor > 0 && !resumed) {
+                qWarning() << "Could not resume game events at cursor" << m_nextCursor << ", Dolphin starts at" << message.cursor;
+                resetGameState();
+            }
+
+            // the backlog ends at next_cursor if Dolphin sends it, nothing is buffered if it is the cursor itself
+            m_catchUpCursor = message.hasNextCursor ? message.nextCursor : -1;
+
+            if(!resumed && (m_catchUpCursor < 0 || m_catchUpCursor > message.cursor)) {
+                // a running game is replayed from its start, fold it in without showing the old frames
+                m_catchingUp = true;
+                m_catchUpTimer.start();
+                m_catchUpFrames = 0;
+            }
+
+            m_currentCursor = m_nextCursor = message.cursor;
+        }
+
+        requirePublish();
+        break;
+    case SlippiMessage::StartGame:
+        m_currentCursor = message.cursor;
+        m_nextCursor = message.nextCursor;
+        m_awaitingResend = m_resyncing = false;
+        break;
+    case SlippiMessage::GameEvent: {
+        bool consumed;
+        if(message.hasEscapes) {
+            // only happens if Dolphin ever starts escaping '/' in the payload
+            QByteArray payloadBase64 = message.decodeLatin1(message.payload);
+            consumed = parseGameEvent(message.cursor, message.nextCursor, payloadBase64);
+        }
+        else {
+            consumed = parseGameEvent(message.cursor, message.nextCursor, message.payload);
+        }
+
+        if(consumed) {
+            m_currentCursor = message.cursor;
+            m_nextCursor = message.nextCursor;
+
+            if(m_catchingUp && m_catchUpCursor >= 0 && m_nextCursor >= m_catchUpCursor) {
+                // the last buffered event, everything after it is live
+                finishCatchUp();
+            }
+        }
+        break;
+    }
+    case SlippiMessage::EndGame:
+        // keep the cursor so a reconnect between games does not replay the last one
+        m_currentCursor = message.cursor;
+        m_nextCursor = message.nextCursor;
+        resetGameState();
+        requirePublish();
+        break;
+    default:
+        qWarning() << "EventDecoder: Unknown message type" << message.typeName;
+        break;
+    }
+
+    m_resumeCursor.store(qMax<qint64>(0, m_nextCursor), std::memory_order_relaxed);
+}
+
+void EventDecoder::resetConnection()
+{
+    // also after connectionLost(), which keeps the state for a resume that will not come
+    resetGameState();
+    m_currentCursor = m_nextCursor = -1;
+    m_resumeCursor = 0;
+    m_catchingUp = false;
+    m_catchUpCursor = -1;
+
+    m_connected = false;
+    m_nick.clear();
+    m_version.clear();
+    requirePublish();
+}
+
+void EventDecoder::connectionLost()
+{
+    // keep the game state and cursor to resume the stream where it stopped
+    m_awaitingResend = false;
+    m_resendRequested = false;
+
+    if(m_connected) {
+        m_connected = false;
+        requirePublish();
+    }
+}
+
+qint64 EventDecoder::resumeCursor() const
+{
+    return m_resumeCursor.load(std::memory_order_relaxed);
+}
+
+bool EventDecoder::takeResendRequest(qint64 &cursor)
+{
+    if(!m_resendRequested.exchange(false)) {
+        return false;
+    }
+
+    cursor = m_resendCursor;
+    return true;
+}
+
+void EventDecoder::flush()
+{
+    if(m_pendingMessages == 0 && !m_publishRequired) {
+        return;
+    }
+
+    if(m_catchingUp) {
+        if(m_lastMessageTimer.isValid() && m_lastMessageTimer.elapsed() < catchUpGap()) {
+            // more of the backlog is on the way, look again once the stream is quiet
+            scheduleFlush(catchUpGap());
+            return;
+        }
+
+        finishCatchUp();
+        return;
+    }
+
+    if(m_deliveryMode == PerBatch || m_publishRequired) {
+        publish();
+        return;
+    }
+
+    // frame or time slice mode: publish once the oldest pending message is due
+    qint64 remaining = m_flushInterval - m_pendingSince.elapsed();
+    if(remaining <= 0) {
+        publish();
+    }
+    else {
+        scheduleFlush(remaining);
+    }
+}
+
+void EventDecoder::scheduleFlush(qint64 delay)
+{
+    if(m_flushScheduled) {
+        return;
+    }
+
+    m_flushScheduled = true;
+
+    if(thread() == QThread::currentThread()) {
+        m_flushTimer.start(int(delay));
+    }
+    else {
+        // decoding runs on a worker thread, the timer belongs to the decoder's thread
+        QMetaObject::invokeMethod(&m_flushTimer, [timer = &m_flushTimer, delay]() {
+            timer->start(int(delay));
+        });
+    }
+}
+
+qint64 EventDecoder::catchUpGap() const
+{
+    // with a known end of the backlog the timer only catches a backlog that stopped short of it
+    return m_catchUpCursor >= 0 ? CATCH_UP_STALL : CATCH_UP_GAP;
+}
+
+void EventDecoder::finishCatchUp()
+{
+    m_catchingUp = false;
+
+    m_deliveryStats.catchUpTime = m_catchUpTimer.elapsed();
+    m_deliveryStats.catchUpFrames = m_catchUpFrames;
+
+    if(m_catchUpFrames > 0) {
+        qDebug() << "Caught up with the running game after" << m_catchUpFrames << "frames in" << m_deliveryStats.catchUpTime << "ms";
+    }
+
+    // the whole backlog is handed over as one update, its latency is in catchUpTime
+    m_pendingSince.start();
+    publish();
+}
+
+void EventDecoder::setExecutor(Executor executor)
+{
+    m_executor = executor;
+}
+
+void EventDecoder::execute(std::function<void()> function)
+{
+    if(m_executor) {
+        m_executor(std::move(function));
+    }
+    else {
+        function();
+    }
+}
+
+void EventDecoder::flushTimeout()
+{
+    execute([this]() {
+        m_flushScheduled = false;
+        flush();
+    });
+}
+
+void EventDecoder::requirePublish()
+{
+    m_publishRequired = true;
+
+    if(m_pendingMessages == 0) {
+        // state changed without a message, e.g. a disconnect
+        m_pendingSince.start();
+    }
+}
+
+void EventDecoder::publish()
+{
+    if(m_catchingUp) {
+        return;
+    }
+
+    DeliveryStats &stats = m_deliveryStats;
+    qint64 latency = m_pendingSince.isValid() ? m_pendingSince.nsecsElapsed() / 1000 : 0;
+
+    stats.flushes++;
+    stats.lastBatchSize = m_pendingMessages;
+    stats.maxBatchSize = qMax(stats.maxBatchSize, m_pendingMessages);
+    stats.totalMessages += m_pendingMessages;
+    stats.lastFlushLatency = latency;
+    stats.maxFlushLatency = qMax(stats.maxFlushLatency, latency);
+    stats.totalFlushLatency += latency;
+
+    if(m_firstOverlayPending) {
+        stats.firstOverlayLatency = m_gameStartTimer.nsecsElapsed() / 1000;
+        m_gameStartTimer.invalidate();
+        m_firstOverlayPending = false;
+    }
+
+    m_pendingMessages = 0;
+    m_pendingSince.invalidate();
+    m_publishRequired = false;
+
+    GameSnapshot &snapshot = m_snapshots.writeBuffer();
+
+    snapshot.connected = m_connected;
+    snapshot.nick = m_nick;
+    snapshot.version = m_version;
+
+    snapshot.gameRunning = m_gameRunning;
+    snapshot.gameSerial = m_gameSerial;
+    snapshot.gameEndSerial = m_gameEndSerial;
+    snapshot.gameInfo = m_game.info;
+    snapshot.gameEnd = m_gameEnd;
+    snapshot.delivery = m_deliveryStats;
+    snapshot.rollback = m_rollbackStats;
+    snapshot.statsEventSerial = m_statsEventSerial;
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        const PlayerState &player = m_game.players[i];
+        snapshot.players[i] = player.info;
+        snapshot.stats[i] = player.leader.stats;
+        snapshot.followerStats[i] = player.follower.stats;
+        snapshot.hasFollower[i] = player.hasFollower;
+    }
+
+    m_snapshots.publish();
+
+    if(!m_publishPending.exchange(true)) {
+        emit snapshotPublished();
+    }
+}
+
+bool EventDecoder::takeSnapshot()
+{
+    // reset first so a publish() during the update is not missed
+    m_publishPending = false;
+
+    return m_snapshots.update();
+}
+
+const GameSnapshot &EventDecoder::snapshot() const
+{
+    return m_snapshots.read();
+}
+
+EventDecoder::StatsEventQueue &EventDecoder::statsEvents()
+{
+    return m_statsEvents;
+}
+
+bool EventDecoder::parseGameEvent(qint64 cursor, qint64 nextCursor, QByteArrayView payloadBase64)
+{
+    // Game events specification: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md
+
+    Q_UNUSED(nextCursor)
+
+    if(cursor != m_nextCursor) {
+        if(cursor < m_nextCursor) {
+            // already decoded, e.g. sent again after a resend request
+            return false;
+        }
+
+        if(!recoverGap(cursor)) {
+            return false;
+        }
+    }
+
+    m_awaitingResend = false;
+
+    if(m_resyncing) {
+        // skip events until the stream is at a frame boundary again
+        char firstByte[3];
+        if(payloadBase64.size() < 4 || Base64::decodeScalar(payloadBase64.data(), 4, firstByte) != 3 ||
+            (firstByte[0] != EVENT_FRAME_START && firstByte[0] != EVENT_PRE_FRAME)) {
+            return true;
+        }
+
+        qDebug() << "Resynchronized game event stream at cursor" << cursor;
+        m_resyncing = false;
+    }
+
+    qsizetype offset = m_input.size();
+    qsizetype payloadSize = Base64::decodedSize(payloadBase64.data(), payloadBase64.size());
+
+    if(payloadSize > m_input.freeSpace()) {
+        // only if a payload is larger than announced in the payload sizes event
+        qWarning() << "Game event" << cursor << "with" << payloadSize << "bytes does not fit the input buffer.";
+        m_input.reserve(offset + payloadSize);
+    }
+
+    // decode the payload straight into the input buffer, or through the scratch buffer if it wraps around
+    char *out = m_input.contiguousWrite(payloadSize);
+    if(!out) {
+        m_payloadScratch.resize(payloadSize);
+        out = m_payloadScratch.data();
+    }
+
+    if(payloadSize == 0 || Base64::decode(payloadBase64.data(), payloadBase64.size(), out) != payloadSize) {
+        qWarning() << "Game event" << cursor << "has an invalid payload.";
+        return true;
+    }
+
+    if(out == m_payloadScratch.constData()) {
+        m_input.write(out, payloadSize);
+    }
+    else {
+        m_input.commit(payloadSize);
+    }
+
+    //qDebug() << "Feed" << payloadSize << "bytes, available now:" << m_input.size();
+
+    if(m_input.at(offset) == EVENT_PAYLOADS) {
+        // command byte, size including the size byte, then 3 bytes per command
+        char header[2];
+        m_input.read(header, 2);
+
+        qsizetype entriesSize = qMax(0, quint8(header[1]) - 1);
+        m_input.read(m_commandScratch.data(), entriesSize);
+
+        parsePayloadSizes(QByteArrayView(m_commandScratch.constData(), entriesSize));
+    }
+    else {
+        //qWarning() << "Did not get payload sizes command byte:" << QString::number(payload[0], 16);
+    }
+
+    bool moreEvents = true;
+    while(moreEvents) {
+        if(m_currentCommandByte == 0 && !m_input.isEmpty()) {
+            char nextCommandByte;
+            m_input.read(&nextCommandByte, 1);
+            m_currentCommandByte = quint8(nextCommandByte);
+
+            //qDebug() << "Next command byte:" << QString::number(m_currentCommandByte, 16);
+        }
+        else {
+//            qDebug() << "Not reading command byte, currently:" << QString::number(m_currentCommandByte, 16) << m_input.size()
+//                     << ", would be:" << QString::number(payload[0], 16);
+        }
+
+        moreEvents = parseCommand();
+    }
+
+    return true;
+}
+
+qsizetype EventDecoder::parseEvents(QByteArrayView events, int maxFrames, int *parsedFrames, bool untilStatsEventsFull)
+{
+    if(m_pendingMessages++ == 0) {
+        m_pendingSince.start();
+    }
+
+    int frames = 0;
+
+    CommandWalk walk = forEachCommand(events, m_payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        if(commandByte == EVENT_PAYLOADS) {
+            parsePayloadSizes(payload);
+            return true;
+        }
+
+        m_currentCommandByte = commandByte;
+        runCommand(payload);
+
+        if(commandByte != EVENT_FRAME_BOOKEND) {
+            return true;
+        }
+
+        return ++frames != maxFrames && (!untilStatsEventsFull || hasStatsEventRoom());
+    });
+
+    // an incomplete command is passed again with the next call
+    m_hasUnknownCommand = walk.status == CommandWalk::UnknownCommand;
+    if(m_hasUnknownCommand) {
+        qWarning() << "Stop at unknown command" << QString::number(quint8(events[walk.pos]), 16) << "at offset" << walk.pos;
+    }
+
+    if(parsedFrames) {
+        *parsedFrames += frames;
+    }
+
+    return walk.pos;
+}
+
+void EventDecoder::resetStream()
+{
+    resetGameState();
+    m_catchingUp = false;
+    m_hasUnknownCommand = false;
+    requirePublish();
+}
+
+void EventDecoder::beginSeek()
+{
+    m_catchingUp = true;
+    m_catchUpCursor = -1;
+    m_catchUpTimer.start();
+    m_catchUpFrames = 0;
+}
+
+void EventDecoder::resumeAt(const GameState &state, qint32 frameNumber)
+{
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        PlayerState &player = m_game.players[i];
+        player.leader = state.players[i].leader;
+        player.follower = state.players[i].follower;
+        player.hasFollower = state.players[i].hasFollower;
+    }
+
+    resetFrameHistory();
+
+    m_frameNumber = frameNumber;
+    m_lastAnalyzedFrame = m_highestAnalyzedFrame = frameNumber;
+    m_hasAnalyzedFrame = true;
+}
+
+bool EventDecoder::recoverGap(qint64 cursor)
+{
+    if(!m_awaitingResend) {
+        qWarning() << "Missing game events from cursor" << m_nextCursor << "to" << cursor - 1 << ", requesting resend.";
+
+        m_awaitingResend = true;
+        m_resendCursor = m_nextCursor;
+        m_resendRequested = true;
+        m_eventsSinceResend = 0;
+        return false;
+    }
+
+    if(++m_eventsSinceResend < RESEND_TIMEOUT_EVENTS) {
+        return false;
+    }
+
+    // resend did not arrive in time, give up on the missing range and continue at the next frame
+    qWarning() << "Missing game events were not resent, resynchronizing at cursor" << cursor;
+
+    m_awaitingResend = false;
+    m_resyncing = true;
+
+    resetInputBuffer();
+
+    for(PlayerState &player : m_game.players) {
+        player.leader.preFrame = player.follower.preFrame = {};
+        player.leader.postFrame = player.follower.postFrame = {};
+    }
+
+    return true;
+}
+
+void EventDecoder::parsePayloadSizes(QByteArrayView entries)
+{
+    //qDebug() << "Parse payload sizes, entries:" << entries.size();
+
+    for(qsizetype i = 0; i + 3 <= entries.size(); i += 3) {
+        const char *entry = entries.data() + i;
+
+        quint8 commandByte = quint8(entry[0]);
+        quint16 payloadSize = quint16(quint8(entry[1]) << 8 | quint8(entry[2]));
+
+        //qDebug() << "Size for command" << QString::number(commandByte, 16) << "=" << payloadSize;
+
+        if(commandByte > EVENT_HIGHEST) {
+            qWarning() << "Unknown commandByte" << QString::number(commandByte, 16) << "in payload size event.";
+            continue;
+        }
+
+        m_payloadSizes[commandByte] = payloadSize;
+    }
+
+    // payload sizes start a game, its version comes with the game start. until then a version of the
+    // last game must not pick the fields
+    m_replayVersion = ~0u;
+
+    m_hasPayloadSizes = true;
+    updateInputCapacity();
+    updateFrameDecoders();
+}
+
+void EventDecoder::updateInputCapacity()
+{
+    quint16 largestPayload = *std::max_element(std::begin(m_payloadSizes), std::end(m_payloadSizes));
+
+    // room for a partially received command plus the next payload, the ring never grows beyond that
+    m_input.reserve(2 * (largestPayload + 1));
+    m_commandScratch.resize(largestPayload);
+}
+
+void EventDecoder::updateFrameDecoders()
+{
+    // the payload size limits the fields as well, in case a version sends less than the spec says
+    m_preFrameDecoder = PreFrameData::decoder(m_replayVersion, m_payloadSizes[EVENT_PRE_FRAME]);
+    m_postFrameDecoder = PostFrameData::decoder(m_replayVersion, m_payloadSizes[EVENT_POST_FRAME]);
+    m_itemUpdateDecoder = ItemUpdateData::decoder(m_replayVersion, m_payloadSizes[EVENT_ITEM_UPDATE]);
+    m_frameBookendDecoder = FrameBookendData::decoder(m_replayVersion, m_payloadSizes[EVENT_FRAME_BOOKEND]);
+    m_hasFrameBookends = m_replayVersion >= replayVersion(3, 0, 0);
+}
+
+bool EventDecoder::parseCommand()
+{
+    if(m_currentCommandByte == 0) {
+        // no command byte received yet
+        //qDebug() << "No command byte received yet.";
+        return false;
+    }
+
+    uint commandSize = m_currentCommandByte > EVENT_HIGHEST ? 0 : m_payloadSizes[m_currentCommandByte];
+
+    if(m_input.size() < qsizetype(commandSize)) {
+        // command not yet received fully, the rest comes with the next game event.
+        // no debug output here, a filtered qDebug() still allocates its stream
+        return false;
+    }
+
+    if(m_currentCommandByte > EVENT_HIGHEST) {
+        qDebug() << "Skip unknown command:" << QString::number(m_currentCommandByte, 16) << "with payload size" << m_input.size();
+        m_currentCommandByte = 0;
+        m_input.clear();
+        return false;
+    }
+
+    // handlers get a view into the input, it is only copied if the command wraps around
+    QByteArrayView command = m_input.peek(commandSize);
+    if(command.isNull()) {
+        m_input.read(m_commandScratch.data(), commandSize);
+        command = QByteArrayView(m_commandScratch.constData(), commandSize);
+    }
+    else {
+        m_input.skip(commandSize);
+    }
+
+    runCommand(command);
+
+    return true;
+}
+
+void EventDecoder::runCommand(QByteArrayView command)
+{
+    qsizetype commandSize = command.size();
+
+    if(m_currentCommandByte == EVENT_SPLIT_MSG) {
+        // the last 4 bytes are the split message header: block size, internal command, last message
+        const uchar *header = reinterpret_cast<const uchar *>(command.data()) + commandSize - 4;
+        quint16 blockSize = qMin<quint16>(qFromBigEndian<quint16>(header), commandSize - 4);
+        quint8 internalCommand = header[2];
+        bool lastMessage = header[3];
+
+        //qDebug() << "Reading a split message for command" << QString::number(internalCommand, 16) << "is last:" << lastMessage;
+
+        // the gecko code list arrives in ~100 fragments right after game start and is not used, skip it
+        if(internalCommand != EVENT_GECKO_LIST) {
+            if(m_commandData.isEmpty() && internalCommand <= EVENT_HIGHEST) {
+                // join the fragments without reallocating
+                m_commandData.reserve(m_payloadSizes[internalCommand]);
+            }
+
+            m_commandData.append(command.first(blockSize));
+        }
+
+        if(!lastMessage) {
+            m_currentCommandByte = 0;
+            return;
+        }
+
+        m_currentCommandByte = internalCommand;
+        command = m_commandData;
+    }
+
+    // can now fully read the command
+    switch(m_currentCommandByte) {
+    case EVENT_GAME_START:
+        parseGameStart(command);
+        break;
+    case EVENT_PRE_FRAME:
+        parsePreFrame(command);
+        break;
+    case EVENT_POST_FRAME:
+        parsePostFrame(command);
+        break;
+    case EVENT_FRAME_START:
+        break;
+    case EVENT_ITEM_UPDATE:
+        if(m_dispatcher.isSubscribed<ItemUpdateData>()) {
+            parseItemUpdate(command);
+        }
+        break;
+    case EVENT_FRAME_BOOKEND:
+        // all players' pre and post frames have arrived, analyze them together.
+        // stats only change here, so every published snapshot holds one complete frame
+        analyzeFrame();
+
+        if(m_catchingUp) {
+            m_catchUpFrames++;
+        }
+
+        if(m_dispatcher.isSubscribed<FrameBookendData>()) {
+            parseFrameBookend(command);
+        }
+
+        if(m_deliveryMode == PerFrame) {
+            // hand off every completed frame as one unit
+            publish();
+        }
+        break;
+    case EVENT_GECKO_LIST:
+        break;
+    case EVENT_GAME_END:
+        parseGameEnd(command);
+        break;
+    default:
+        qWarning() << "Command" << QString::number(m_currentCommandByte, 16) << "not implemented.";
+        break;
+    }
+
+    // done reading current command, keeps the capacity for the next split message
+    m_commandData.resize(0);
+    m_currentCommandByte = 0;
+}
+
+bool EventDecoder::parseGameStart(QByteArrayView command)
+{
+    m_game = GameState();
+    resetFrameHistory();
+
+    m_replayVersion = readGameStart(command, m_game);
+    updateFrameDecoders();
+
+    m_gameRunning = true;
+    m_gameSerial++;
+
+    m_dispatcher.dispatch(m_game);
+
+    // show the players right away, the gecko code list burst follows in the same batch
+    m_gameStartTimer.start();
+    m_firstOverlayPending = false;
+    publish();
+
+    return true;
+}
+
+quint32 EventDecoder::readGameStart(QByteArrayView command, GameState &game)
+{
+    QDataStream stream(QByteArray::fromRawData(command.data(), command.size()));
+
+    quint8 version[4] = { 0 };
+    stream.readRawData((char*)&version, 4);
+
+    GameInfo &gi = game.info;
+    PlayerState *players = game.players;
+
+    gi.version = QString("%1.%2.%3 (%4)").arg(version[0]).arg(version[1]).arg(version[2]).arg(version[3]);
+
+    char gameInfoBlock[312] = { 0 };
+    stream.readRawData(gameInfoBlock, 312);
+
+    QDataStream gameInfoStream(QByteArray(gameInfoBlock, 312));
+    gameInfoStream.skipRawData(0x0E);
+    gameInfoStream >> gi.stageId;
+    gameInfoStream.skipRawData(0x60 - 0x10);
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        gameInfoStream >> players[i].info.charId;
+        gameInfoStream >> players[i].info.playerType;
+
+        gameInfoStream.skipRawData(0x22);
+    }
+
+    stream >> gi.seed;
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        stream >> players[i].info.dashbackFix;
+    }
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        stream >> players[i].info.shieldDropFix;
+    }
+
+    QTextCodec *jisCodec = QTextCodec::codecForName("Shift-JIS");
+
+    if(jisCodec == nullptr) {
+        qWarning() << "Could not find Shift-JIS codec.";
+        jisCodec = QTextCodec::codecForLocale();
+    }
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        char rawTag[16] = { 0 };
+        stream.readRawData(rawTag, 16);
+        players[i].info.nameTag = jisCodec->toUnicode(rawTag);
+    }
+
+    stream >> gi.isPal >> gi.isFrozenPS >> gi.minorScene >> gi.majorScene;
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        char rawName[31] = { 0 };
+        stream.readRawData(rawName, 31);
+        players[i].info.slippiName = jisCodec->toUnicode(rawName);
+    }
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        char rawCode[10] = { 0 };
+        stream.readRawData(rawCode, 10);
+        QString codeStr = jisCodec->toUnicode(rawCode);
+
+        // replace full-width (Unicode 0xff03) hash with regular (half-width) hash
+        players[i].info.slippiCode = codeStr.replace(QChar(0xff03), '#');
+    }
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        char rawUid[29] = { 0 };
+        stream.readRawData(rawUid, 29);
+        players[i].info.slippiUid = QString::fromUtf8(rawUid);
+    }
+
+    stream >> gi.languageOption;
+
+    char rawMatchId[51] = { 0 };
+    stream.readRawData(rawMatchId, 51);
+    gi.matchId = QString::fromUtf8(rawMatchId);
+
+    stream >> gi.gameNumber >> gi.tiebreakerNumber;
+
+    return replayVersion(version[0], version[1], version[2]);
+}
+
+bool EventDecoder::parsePreFrame(QByteArrayView command)
+{
+    PreFrameData d;
+    m_preFrameDecoder(d, reinterpret_cast<const uchar *>(command.data()));
+
+    if(d.playerIndex >= NUM_PLAYERS) {
+        return false;
+    }
+
+    m_frameNumber = d.frameNumber;
+
+    PlayerState &player = m_game.players[d.playerIndex];
+    player.hasFollower |= d.isFollower;
+    player.character(d.isFollower).preFrame = d;
+    m_dispatcher.dispatch(d);
+
+    return true;
+}
+
+bool EventDecoder::parsePostFrame(QByteArrayView command)
+{
+    PostFrameData d;
+    m_postFrameDecoder(d, reinterpret_cast<const uchar *>(command.data()));
+
+    if(d.playerIndex >= NUM_PLAYERS) {
+        return false;
+    }
+
+    m_frameNumber = d.frameNumber;
+
+    PlayerState &player = m_game.players[d.playerIndex];
+    player.hasFollower |= d.isFollower;
+    player.character(d.isFollower).postFrame = d;
+    m_dispatcher.dispatch(d);
+
+    if(!m_hasFrameBookends) {
+        // older replays end a frame with the last post frame, analyze each player as it completes
+        analyzeFrame();
+    }
+
+    return true;
+}
+
+void EventDecoder::analyzeFrame()
+{
+    qint32 frame = m_frameNumber;
+
+    // online play resends frames after a rollback, continue from the state before the first resent frame.
+    // without bookends every player's post frame calls this, the frame number does not mean anything then
+    bool reanalyzing = m_hasFrameBookends && m_hasAnalyzedFrame && frame <= m_highestAnalyzedFrame;
+
+    QElapsedTimer reanalysisTimer;
+    if(reanalyzing) {
+        reanalysisTimer.start();
+
+        if(frame <= m_lastAnalyzedFrame) {
+            rollbackTo(frame);
+        }
+    }
+
+    saveFrameHistory(frame);
+
+    for(quint8 i = 0; i < NUM_PLAYERS; i++) {
+        analyzeCharacter(i, false);
+
+        if(m_game.players[i].hasFollower) {
+            analyzeCharacter(i, true);
+        }
+    }
+
+    m_lastAnalyzedFrame = frame;
+    m_highestAnalyzedFrame = m_hasAnalyzedFrame ? qMax(m_highestAnalyzedFrame, frame) : frame;
+    m_hasAnalyzedFrame = true;
+
+    if(reanalyzing) {
+        m_rollbackStats.reanalyzedFrames++;
+        m_rollbackStats.reanalysisTime += reanalysisTimer.nsecsElapsed() / 1000;
+    }
+}
+
+void EventDecoder::saveFrameHistory(qint32 frame)
+{
+    FrameHistoryEntry &entry = m_frameHistory[frame & (ROLLBACK_HISTORY - 1)];
+    entry.frameNumber = frame;
+    entry.valid = true;
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        entry.characters[i][0] = m_game.players[i].leader;
+        entry.characters[i][1] = m_game.players[i].follower;
+    }
+}
+
+bool EventDecoder::rollbackTo(qint32 frame)
+{
+    m_rollbackStats.rollbacks++;
+    m_rollbackStats.maxDepth = qMax(m_rollbackStats.maxDepth, int(m_lastAnalyzedFrame - frame + 1));
+
+    const FrameHistoryEntry &entry = m_frameHistory[frame & (ROLLBACK_HISTORY - 1)];
+    if(!entry.valid || entry.frameNumber != frame) {
+        qWarning() << "Rollback to frame" << frame << "is older than the history, analyzing it as a new frame.";
+        m_rollbackStats.lostRollbacks++;
+        return false;
+    }
+
+    // keep the resent frame data, only the analysis state goes back.
+    // overlay events of the replaced frames were already queued, the snapshots carry the corrected stats
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        for(int slot = 0; slot < 2; slot++) {
+            CharacterState &character = m_game.players[i].character(slot == 1);
+            PreFrameData preFrame = character.preFrame;
+            PostFrameData postFrame = character.postFrame;
+
+            character = entry.characters[i][slot];
+            character.preFrame = preFrame;
+            character.postFrame = postFrame;
+        }
+    }
+
+    return true;
+}
+
+void EventDecoder::resetFrameHistory()
+{
+    for(FrameHistoryEntry &entry : m_frameHistory) {
+        entry.valid = false;
+    }
+
+    m_hasAnalyzedFrame = false;
+}
+
+void EventDecoder::analyzeCharacter(quint8 playerIndex, bool isFollower)
+{
+    PlayerState &player = m_game.players[playerIndex];
+    CharacterState &character = player.character(isFollower);
+    PlayerStats previous = character.stats;
+
+    if(!character.analyzeFrame(player.info.charId)) {
+        return;
+    }
+
+    if(m_gameStartTimer.isValid()) {
+        m_firstOverlayPending = true;
+    }
+
+    // the frames of the backlog only build up the state, their overlays are long over
+    if(m_catchingUp || !character.stats.isOverlayEvent(previous)) {
+        return;
+    }
+
+    // a full queue drops the event, the latest state still reaches the GUI with the next snapshot
+    PlayerStatsEvent event;
+    event.serial = m_statsEventSerial++;
+    event.gameSerial = m_gameSerial;
+    event.player = playerIndex;
+    event.follower = isFollower;
+    event.stats = character.stats;
+
+    m_statsEvents.push(event);
+}
+
+bool EventDecoder::parseItemUpdate(QByteArrayView command)
+{
+    ItemUpdateData d;
+    m_itemUpdateDecoder(d, reinterpret_cast<const uchar *>(command.data()));
+
+    m_dispatcher.dispatch(d);
+
+    return true;
+}
+
+bool EventDecoder::parseFrameBookend(QByteArrayView command)
+{
+    FrameBookendData d;
+    m_frameBookendDecoder(d, reinterpret_cast<const uchar *>(command.data()));
+
+    m_dispatcher.dispatch(d);
+
+    return true;
+}
+
+bool EventDecoder::parseGameEnd(QByteArrayView command)
+{
+    QDataStream stream(QByteArray::fromRawData(command.data(), command.size()));
+
+    stream >> m_gameEnd.method >> m_gameEnd.lrasPlayer;
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        stream >> m_gameEnd.placements[i];
+    }
+
+    m_gameEndSerial = m_gameSerial;
+    m_dispatcher.dispatch(m_gameEnd);
+    requirePublish();
+
+    return true;
+}
+
+void EventDecoder::resetInputBuffer()
+{
+    m_input.clear();
+    m_currentCommandByte = 0;
+    m_commandData.resize(0);
+}
+
+void EventDecoder::resetGameState()
+{
+    // reset state for next game:
+    //m_hasPayloadSizes = false;
+    resetInputBuffer();
+    m_awaitingResend = m_resyncing = false;
+    m_resendRequested = false;
+    m_game = GameState();
+    resetFrameHistory();
+
+    m_replayVersion = ~0u;
+    updateFrameDecoders();
+
+    m_gameRunning = false;
+}
+
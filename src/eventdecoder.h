@@ -0,0 +1,284 @@
+#ifndef EVENTDECODER_H
+#define EVENTDECODER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <atomic>
+#include <functional>
+
+#include "boundedqueue.h"
+#include "bytering.h"
+#include "eventdispatcher.h"
+#include "gamestate.h"
+#include "slippimessage.h"
+#include "triplebuffer.h"
+
+// decodes the Slippi spectator stream and runs the per-frame analysis.
+// lives in the thread that feeds it (the DolphinConnection thread for live games),
+// the GUI only sees the results through the GameSnapshot published after each batch.
+class EventDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // events from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#events
+    enum SlippiEvents {
+        EVENT_SPLIT_MSG     = 0x10,
+        EVENT_PAYLOADS      = 0x35,
+        EVENT_GAME_START    = 0x36,
+        EVENT_PRE_FRAME     = 0x37,
+        EVENT_POST_FRAME    = 0x38,
+        EVENT_GAME_END      = 0x39,
+        EVENT_FRAME_START   = 0x3A,
+        EVENT_ITEM_UPDATE   = 0x3B,
+        EVENT_FRAME_BOOKEND = 0x3c,
+        EVENT_GECKO_LIST    = 0x3D,
+        EVENT_UNKNOWN       = 0x45,
+        EVENT_HIGHEST       = EVENT_UNKNOWN
+    };
+
+    // when the decoded state is handed to the reading side
+    enum DeliveryMode {
+        PerBatch,   // after every batch of messages received together
+        PerFrame,   // on every frame bookend, bounded by the flush interval
+        TimeSlice   // at most once per flush interval
+    };
+    Q_ENUM(DeliveryMode)
+
+    explicit EventDecoder(QObject *parent = nullptr);
+
+    void setDeliveryMode(DeliveryMode mode, int flushInterval);
+
+    // decoding side, only call from the thread the decoder lives in
+    void parseMessage(const SlippiMessage &message);
+    void parseMessageData(QByteArrayView data);
+
+    // drops the game state and cursors, connected or not, e.g. when the stream is removed or abandoned
+    void resetConnection();
+
+    // keeps the game state so the stream can be resumed from resumeCursor() after reconnecting
+    void connectionLost();
+
+    // raw game events without the message wrapping, e.g. the raw array of a .slp file.
+    // the data is not copied, returns the number of bytes of complete commands that were parsed.
+    // stops after maxFrames frame bookends if maxFrames > 0, the number of bookends is added to parsedFrames.
+    // with untilStatsEventsFull it also stops after the frame bookend that leaves no room for another frame
+    // in statsEvents(), so a reader that is faster than the GUI drops no overlay events
+    qsizetype parseEvents(QByteArrayView events, int maxFrames = 0, int *parsedFrames = nullptr, bool untilStatsEventsFull = false);
+
+    // true if the last parseEvents() stopped at a command without a payload size instead of the end of the
+    // events, nothing after it can be parsed
+    bool hasUnknownCommand() const { return m_hasUnknownCommand; }
+
+    // drops the game state and any partial command, e.g. before reading another replay
+    void resetStream();
+
+    // seeking in a replay: everything that is parsed until the next flush() only builds up the state
+    // and is published as one update, like the backlog when joining a running game
+    void beginSeek();
+
+    // continues after frameNumber with the characters' analysis state from state, e.g. from a SeekIndex keyframe.
+    // the game start must have been parsed before, frames that are resent from before frameNumber count as lost rollbacks
+    void resumeAt(const GameState &state, qint32 frameNumber);
+
+    // fills the game and player info from the data of a game start event, returns the replay version.
+    // does not touch any decoder state, e.g. for indexing replays without decoding them
+    static quint32 readGameStart(QByteArrayView command, GameState &game);
+
+    // the state after the last decoded event, e.g. for handlers of frame bookends
+    const GameState &gameState() const { return m_game; }
+
+    // size of the buffer for partially received commands, set by the payload sizes and not by the game's length
+    qsizetype inputCapacity() const { return m_input.capacity(); }
+
+    // true if events are missing and Dolphin should resend them starting at cursor.
+    // both can be called from any thread
+    qint64 resumeCursor() const;
+    bool takeResendRequest(qint64 &cursor);
+
+    // runs deferred work (the flush timeout) in the same order as the decoding calls,
+    // set when decoding happens on a worker pool instead of the decoder's thread
+    using Executor = std::function<void(std::function<void()>)>;
+    void setExecutor(Executor executor);
+
+    // runs function in order with the decoding, on the executor if one is set and else right away.
+    // call from the thread the decoder lives in, e.g. for decoding calls that do not come from the connection
+    void execute(std::function<void()> function);
+
+    // called after each batch of messages, publishes depending on the delivery mode
+    void flush();
+
+    // makes the current state available to the reading side
+    void publish();
+
+    // reading side, returns true if a new snapshot was picked up
+    bool takeSnapshot();
+    const GameSnapshot &snapshot() const;
+
+    // overlay events of every frame, see GameSnapshot::statsEventSerial
+    static const int STATS_EVENT_CAPACITY = 256;
+    using StatsEventQueue = BoundedQueue<PlayerStatsEvent, STATS_EVENT_CAPACITY>;
+    StatsEventQueue &statsEvents();
+
+    // one overlay event per character at most, leader and follower of every player
+    static const int MAX_STATS_EVENTS_PER_FRAME = 2 * NUM_PLAYERS;
+
+    // decoding side, true if statsEvents() can take the overlay events of one more frame
+    bool hasStatsEventRoom() const { return m_statsEvents.size() <= STATS_EVENT_CAPACITY - MAX_STATS_EVENTS_PER_FRAME; }
+
+    // in-process consumers like recorders or exporters, the game start is passed as GameState.
+    // handlers run on the decoding thread right after the event was decoded, subscribe before the
+    // first message arrives. item updates and frame bookends are only decoded if they have a handler,
+    // pre and post frame events are always decoded because the analysis needs them
+    using Dispatcher = EventDispatcher<GameState, PreFrameData, PostFrameData, ItemUpdateData, FrameBookendData, GameEndInfo>;
+
+    template<typename Event>
+    void subscribe(Dispatcher::Handler<Event> handler) { m_dispatcher.subscribe<Event>(std::move(handler)); }
+
+    // without the std::function indirection, function has to stay alive while events are decoded
+    template<typename Event, typename Function>
+    void subscribeRef(Function &function) { m_dispatcher.subscribeRef<Event>(function); }
+
+signals:
+    // emitted from the decoding thread, at most once until the next takeSnapshot()
+    void snapshotPublished();
+
+private:
+    // returns false if the event was dropped without advancing the cursor
+    bool parseGameEvent(qint64 cursor, qint64 nextCursor, QByteArrayView payloadBase64);
+    bool recoverGap(qint64 cursor);
+    void resetInputBuffer();
+
+    // entries of the payload sizes event, 3 bytes per command
+    void parsePayloadSizes(QByteArrayView entries);
+    void updateInputCapacity();
+    void updateFrameDecoders();
+
+    // takes the next command from m_input, runCommand() handles m_currentCommandByte
+    bool parseCommand();
+    void runCommand(QByteArrayView command);
+
+    // command data without the command byte, only valid during the call
+    bool parseGameStart(QByteArrayView command);
+
+    // the frame events only store their data, the analysis runs once per frame
+    bool parsePreFrame(QByteArrayView command);
+    bool parsePostFrame(QByteArrayView command);
+    void analyzeFrame();
+    void analyzeCharacter(quint8 playerIndex, bool isFollower);
+
+    // the analysis state before each of the last frames, restored when frames are resent after a rollback
+    void saveFrameHistory(qint32 frame);
+    bool rollbackTo(qint32 frame);
+    void resetFrameHistory();
+
+    bool parseItemUpdate(QByteArrayView command);
+    bool parseFrameBookend(QByteArrayView command);
+
+    bool parseGameEnd(QByteArrayView command);
+    void resetGameState();
+
+    // state changes that are published with the next flush() regardless of the delivery mode
+    void requirePublish();
+    void scheduleFlush(qint64 delay);
+    void flushTimeout();
+
+    // catch-up: when connecting to a running game, Dolphin sends all of its events at once.
+    // nothing is published until the event before connect_reply's next_cursor is decoded, then the state
+    // goes out as one update. without a next_cursor, the backlog ends when the stream pauses for CATCH_UP_GAP ms
+    qint64 catchUpGap() const;
+    void finishCatchUp();
+
+    QString m_nick;
+    QString m_version;
+
+    bool m_connected = false;
+    bool m_gameRunning = false;
+    quint32 m_gameSerial = 0, m_gameEndSerial = 0;
+
+    qint64 m_currentCursor = -1, m_nextCursor = -1;
+
+    // gap recovery: wait this many events for a resend before resynchronizing at the next frame
+    static const int RESEND_TIMEOUT_EVENTS = 60;
+    bool m_awaitingResend = false, m_resyncing = false;
+    int m_eventsSinceResend = 0;
+
+    // read by the connection thread
+    std::atomic<qint64> m_resumeCursor = 0, m_resendCursor = 0;
+    std::atomic<bool> m_resendRequested = false;
+
+    bool m_hasPayloadSizes = false;
+    bool m_hasUnknownCommand = false;
+    quint16 m_payloadSizes[EVENT_HIGHEST + 1] = { 0 };
+
+    // chosen per game from the replay version and payload sizes. the version is unknown
+    // when joining a running game, then only the payload sizes decide which fields are read
+    quint32 m_replayVersion = ~0u;
+    PreFrameData::Decoder m_preFrameDecoder = nullptr;
+    PostFrameData::Decoder m_postFrameDecoder = nullptr;
+    ItemUpdateData::Decoder m_itemUpdateDecoder = nullptr;
+    FrameBookendData::Decoder m_frameBookendDecoder = nullptr;
+    bool m_hasFrameBookends = true; // sent since 3.0.0
+
+    quint8 m_currentCommandByte = 0;
+
+    // decoded bytes not yet consumed by parseCommand()
+    ByteRing m_input;
+    QByteArray m_payloadScratch;
+
+    // a command that wraps around the end of m_input, sized like the largest payload
+    QByteArray m_commandScratch;
+
+    // fragments of a split message, reserved for the joined size on the first fragment
+    QByteArray m_commandData;
+
+    GameState m_game;
+    GameEndInfo m_gameEnd;
+
+    Dispatcher m_dispatcher;
+
+    // online play rolls back at most 7 frames
+    static const int ROLLBACK_HISTORY = 8;
+    struct FrameHistoryEntry {
+        qint32 frameNumber = 0;
+        bool valid = false;
+        CharacterState characters[NUM_PLAYERS][2]; // leader and follower
+    };
+
+    FrameHistoryEntry m_frameHistory[ROLLBACK_HISTORY];
+    qint32 m_frameNumber = 0;
+    qint32 m_lastAnalyzedFrame = 0, m_highestAnalyzedFrame = 0;
+    bool m_hasAnalyzedFrame = false;
+    RollbackStats m_rollbackStats;
+
+    TripleBuffer<GameSnapshot> m_snapshots;
+    StatsEventQueue m_statsEvents;
+    quint32 m_statsEventSerial = 0;
+    std::atomic<bool> m_publishPending = false;
+
+    DeliveryMode m_deliveryMode = PerFrame;
+    int m_flushInterval = 16;
+    QTimer m_flushTimer;
+    bool m_flushScheduled = false;
+    Executor m_executor;
+
+    static const int CATCH_UP_GAP = 8; // live frames are ~16 ms apart
+    static const int CATCH_UP_STALL = 500;
+    bool m_catchingUp = false;
+    qint64 m_catchUpCursor = -1;
+    QElapsedTimer m_catchUpTimer, m_lastMessageTimer;
+    quint32 m_catchUpFrames = 0;
+
+    bool m_publishRequired = false;
+    quint32 m_pendingMessages = 0;
+    QElapsedTimer m_pendingSince;
+    DeliveryStats m_deliveryStats;
+
+    // time from the game start event to the first published frame, see DeliveryStats::firstOverlayLatency
+    QElapsedTimer m_gameStartTimer;
+    bool m_firstOverlayPending = false;
+};
+
+#endif // EVENTDECODER_H
@@ -0,0 +1,83 @@
+#ifndef EVENTDISPATCHER_H
+#define EVENTDISPATCHER_H
+
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// typed handlers for a fixed set of event types, flat lists per type.
+// the lists are picked by the event type at compile time. a std::function handler costs an indirect
+// call through its type erasure per event, subscribeRef() handlers a plain function pointer call
+// with the handler's own call inlined behind it. an event type nobody subscribed to costs only the
+// empty check, its decoding can be skipped with isSubscribed()
+template<typename... Events>
+class EventDispatcher
+{
+public:
+    template<typename Event>
+    using Handler = std::function<void(const Event &)>;
+
+    template<typename Event>
+    void subscribe(Handler<Event> handler) {
+        handlers<Event>().push_back(std::move(handler));
+    }
+
+    // for handlers of frequent events, function is not copied and has to stay alive while events are dispatched
+    template<typename Event, typename Function>
+    void subscribeRef(Function &function) {
+        callbacks<Event>().push_back({ &call<Event, Function>, &function });
+    }
+
+    template<typename Event>
+    bool isSubscribed() const {
+        return !callbacks<Event>().empty() || !handlers<Event>().empty();
+    }
+
+    template<typename Event>
+    void dispatch(const Event &event) const {
+        for(const Callback<Event> &callback : callbacks<Event>()) {
+            callback.function(callback.context, event);
+        }
+        for(const Handler<Event> &handler : handlers<Event>()) {
+            handler(event);
+        }
+    }
+
+private:
+    template<typename Event>
+    struct Callback {
+        void (*function)(void *context, const Event &event);
+        void *context;
+    };
+
+    template<typename Event, typename Function>
+    static void call(void *context, const Event &event) {
+        (*static_cast<Function *>(context))(event);
+    }
+
+    template<typename Event>
+    std::vector<Handler<Event>> &handlers() {
+        return std::get<std::vector<Handler<Event>>>(m_handlers);
+    }
+
+    template<typename Event>
+    const std::vector<Handler<Event>> &handlers() const {
+        return std::get<std::vector<Handler<Event>>>(m_handlers);
+    }
+
+    template<typename Event>
+    std::vector<Callback<Event>> &callbacks() {
+        return std::get<std::vector<Callback<Event>>>(m_callbacks);
+    }
+
+    template<typename Event>
+    const std::vector<Callback<Event>> &callbacks() const {
+        return std::get<std::vector<Callback<Event>>>(m_callbacks);
+    }
+
+    std::tuple<std::vector<Callback<Events>>...> m_callbacks;
+    std::tuple<std::vector<Handler<Events>>...> m_handlers;
+};
+
+#endif // EVENTDISPATCHER_H
@@ -1,493 +1,287 @@
 #include "eventparser.h"
 
-#include <QVariant>
-#include <QTextCodec>
-#include <QtEndian>
-#include <QVector2D>
-
 EventParser::EventParser(QObject *parent) : QObject{parent},
-    m_dataStream(&m_dataBuffer, QIODevice::OpenModeFlag::ReadOnly),
-    m_writeStream(&m_dataBuffer, QIODevice::OpenModeFlag::WriteOnly)
+    m_decoder(new EventDecoder, &QObject::deleteLater) // released in the thread it was moved to
 {
-    m_dataStream.setByteOrder(QDataStream::ByteOrder::BigEndian);
-    m_dataStream.setFloatingPointPrecision(QDataStream::FloatingPointPrecision::SinglePrecision);
-
-    // add default values. current version of mainline beta only sends sizes for the first game of the session.
-    m_payloadSizes[0x10] = 516;
-    m_payloadSizes[0x36] = 760;
-    m_payloadSizes[0x37] = 64;
-    m_payloadSizes[0x38] = 84;
-    m_payloadSizes[0x39] = 6;
-    m_payloadSizes[0x3a] = 12;
-    m_payloadSizes[0x3b] = 44;
-    m_payloadSizes[0x3c] = 8;
-    m_payloadSizes[0x3d] = 54480;
-
-    m_payloadSizes[0x45] = 36; // some unknown command it sends if connecting to a running game
-
-    resetGameState();
+    // queued, the decoder might live in another thread
+    connect(m_decoder.data(), &EventDecoder::snapshotPublished,
+            this, &EventParser::updateSnapshot, Qt::QueuedConnection);
+
+    updateDeliveryMode();
 }
 
-void EventParser::parseSlippiMessage(const QVariantMap &event)
+QSharedPointer<EventDecoder> EventParser::decoder() const
 {
-    QString type = event["type"].toString();
-
-    if(type == "connect_reply") {
-        m_nick = event["nick"].toString();
-        m_version = event["version"].toString();
-        m_connected = true;
-        emit connectedChanged();
-    }
-    else if(type == "start_game") {
-        m_currentCursor = event["cursor"].toInt();
-        m_nextCursor = event["next_cursor"].toInt();
-    }
-    else if(type == "game_event") {
-        int cursor = event["cursor"].toInt();
-        int nextCursor = event["next_cursor"].toInt();
-        QString payloadBase64 = event["payload"].toString();
-        QByteArray payload = QByteArray::fromBase64(payloadBase64.toLocal8Bit());
-
-        parseGameEvent(cursor, nextCursor, payload);
+    return m_decoder;
+}
 
-        m_currentCursor = cursor;
-        m_nextCursor = nextCursor;
-    }
-    else if(type == "end_game") {
-        resetGameState();
-    }
-    else {
-        qWarning() << "EventParser: Unknown message type" << type;
-    }
+EventDecoder::DeliveryMode EventParser::deliveryMode() const
+{
+    return m_deliveryMode;
 }
 
-void EventParser::disconnnect()
+void EventParser::setDeliveryMode(EventDecoder::DeliveryMode mode)
 {
-    if(!m_connected) {
-        qWarning() << "EventParser: not connected, cannot disconnect.";
+    if(m_deliveryMode == mode)
         return;
-    }
-
-    resetGameState();
 
-    m_connected = false;
-    emit connectedChanged();
+    m_deliveryMode = mode;
+    updateDeliveryMode();
+    emit deliveryModeChanged();
 }
 
-void EventParser::parseGameEvent(int cursor, int nextCursor, const QByteArray &payload)
+int EventParser::flushInterval() const
 {
-    // Game events specification: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md
+    return m_flushInterval;
+}
 
-    if(cursor != m_nextCursor) {
-        qWarning() << "Game event cursors do not match: expected" << m_nextCursor << ", got" << cursor;
+void EventParser::setFlushInterval(int flushInterval)
+{
+    if(m_flushInterval == flushInterval)
         return;
-    }
-
-    m_writeStream.writeRawData(payload.constData(), payload.size());
-    m_availableBytes += payload.size();
-
-    //qDebug() << "Feed" << payload.size() << "bytes, available now:" << m_availableBytes;
 
-    if(payload[0] == EVENT_PAYLOADS) {
-        parsePayloadSizes();
-    }
-    else {
-        //qWarning() << "Did not get payload sizes command byte:" << QString::number(payload[0], 16);
-    }
-
-    bool moreEvents = true;
-    while(moreEvents) {
-        if(m_currentCommandByte == 0 && m_availableBytes > 0) {
-            quint8 nextCommandByte;
-            m_dataStream >> nextCommandByte;
-            m_currentCommandByte = nextCommandByte;
-            m_availableBytes--;
-
-            //qDebug() << "Next command byte:" << QString::number(m_currentCommandByte, 16);
-        }
-        else {
-//            qDebug() << "Not reading command byte, currently:" << QString::number(m_currentCommandByte, 16) << m_availableBytes
-//                     << ", would be:" << QString::number(payload[0], 16);
-        }
+    m_flushInterval = flushInterval;
+    updateDeliveryMode();
+    emit deliveryModeChanged();
+}
 
-        moreEvents = parseCommand();
-    }
+void EventParser::updateDeliveryMode()
+{
+    QMetaObject::invokeMethod(m_decoder.data(), [decoder = m_decoder, mode = m_deliveryMode, interval = m_flushInterval]() {
+        decoder->execute([decoder, mode, interval]() {
+            decoder->setDeliveryMode(mode, interval);
+        });
+    });
 }
 
-void EventParser::parsePayloadSizes()
+qreal EventParser::averageBatchSize() const
 {
-    qint8 payloadCommandByte;
-    quint8 payloadSizeLength;
-    m_dataStream >> payloadCommandByte >> payloadSizeLength;
+    return m_deliveryStats.flushes > 0 ? qreal(m_deliveryStats.totalMessages) / m_deliveryStats.flushes : 0;
+}
 
-    //qDebug() << "Parse payload sizes, command size:" << payloadSizeLength << ", command byte:" << QString::number(payloadCommandByte, 16);
+qreal EventParser::averageFlushLatency() const
+{
+    return m_deliveryStats.flushes > 0 ? qreal(m_deliveryStats.totalFlushLatency) / m_deliveryStats.flushes : 0;
+}
 
-    for(int i = 1; i < payloadSizeLength; i+=3) {
-        quint8 commandByte;
-        quint16 payloadSize;
-        m_dataStream >> commandByte >> payloadSize;
+quint64 EventParser::droppedSnapshots() const
+{
+    return m_deliveryStats.flushes - qMin<quint64>(m_deliveryStats.flushes, m_takenSnapshots);
+}
 
-        //qDebug() << "Size for command" << QString::number(commandByte, 16) << "=" << payloadSize;
+int EventParser::statsEventHighWaterMark() const
+{
+    return m_decoder->statsEvents().highWaterMark();
+}
 
-        if(commandByte < 0 || commandByte > EVENT_HIGHEST) {
-            qWarning() << "Unknown commandByte" << QString::number(commandByte, 16) << "in payload size event.";
-            continue;
-        }
+quint64 EventParser::droppedStatsEvents() const
+{
+    return m_decoder->statsEvents().dropped();
+}
 
-        m_payloadSizes[commandByte] = payloadSize;
-    }
+void EventParser::parseSlippiMessage(const QVariantMap &event)
+{
+    QByteArray type = event["type"].toString().toUtf8();
+    QByteArray payload = event["payload"].toString().toLatin1();
+    QByteArray nick = event["nick"].toString().toUtf8();
+    QByteArray version = event["version"].toString().toUtf8();
+    qint64 cursor = event["cursor"].toLongLong();
+    qint64 nextCursor = event["next_cursor"].toLongLong();
+    bool hasNextCursor = event.contains("next_cursor");
+
+    // with a worker pool the connection decodes on StreamWorker tasks, execute() queues behind them
+    QMetaObject::invokeMethod(m_decoder.data(), [=, decoder = m_decoder]() {
+        decoder->execute([=]() {
+            SlippiMessage message;
+            message.typeName = type;
+            message.type = SlippiMessage::typeFromName(type);
+            message.cursor = cursor;
+            message.nextCursor = nextCursor;
+            message.hasNextCursor = hasNextCursor;
+            message.payload = payload;
+            message.nick = nick;
+            message.version = version;
+
+            decoder->parseMessage(message);
+            decoder->flush();
+        });
+    });
+}
 
-    m_availableBytes -= payloadSizeLength + 1; // payload size + command byte
-    m_hasPayloadSizes = true;
+void EventParser::disconnnect()
+{
+    QMetaObject::invokeMethod(m_decoder.data(), [decoder = m_decoder]() {
+        decoder->execute([decoder]() {
+            decoder->resetConnection();
+            decoder->flush();
+        });
+    });
 }
 
-bool EventParser::parseCommand()
+void EventParser::updateSnapshot()
 {
-    if(m_currentCommandByte == 0) {
-        // no command byte received yet
-        //qDebug() << "No command byte received yet.";
-        return false;
+    if(!m_decoder->takeSnapshot()) {
+        return;
     }
 
-    uint commandSize = m_currentCommandByte > EVENT_HIGHEST ? 0 : m_payloadSizes[m_currentCommandByte];
+    const GameSnapshot &snapshot = m_decoder->snapshot();
 
-    if(m_availableBytes < commandSize) {
-        // command not yet received fully
-        qDebug() << "Command" << QString::number(m_currentCommandByte, 16) << "needs" << commandSize << "bytes, but only received" << m_availableBytes << "yet.";
-        return false;
-    }
+    m_takenSnapshots++;
+    m_deliveryStats = snapshot.delivery;
+    emit deliveryStatsChanged();
 
-    if(m_currentCommandByte > EVENT_HIGHEST) {
-        qDebug() << "Skip unknown command:" << QString::number(m_currentCommandByte, 16) << "with payload size" << m_availableBytes;
-        m_currentCommandByte = 0;
-        m_dataStream.skipRawData(m_availableBytes);
-        m_availableBytes = 0;
-        return false;
+    if(snapshot.rollback.reanalyzedFrames != m_rollbackStats.reanalyzedFrames ||
+       snapshot.rollback.rollbacks != m_rollbackStats.rollbacks) {
+        m_rollbackStats = snapshot.rollback;
+        emit rollbackStatsChanged();
     }
 
-    char *bytes = new char[commandSize];
-    m_dataStream.readRawData(bytes, commandSize);
-    m_availableBytes -= commandSize;
-
-    if(m_currentCommandByte == EVENT_SPLIT_MSG) {
-        quint8 internalCommand = bytes[commandSize - 4];
-        quint16 actualSize = *((quint16*)&bytes[commandSize - 3]);
-        bool lastMessage = bytes[commandSize - 1];
-
-        commandSize -= 4;
-
-        //qDebug() << "Reading a split message for command" << QString::number(internalCommand, 16) << ", actual size:" << actualSize << "is last:" << lastMessage;
-        Q_UNUSED(actualSize) // is always 512, or less for the last message
-
-        if(lastMessage) {
-            m_currentCommandByte = internalCommand;
-        }
+    if(snapshot.connected != m_connected || snapshot.nick != m_nick || snapshot.version != m_version) {
+        m_connected = snapshot.connected;
+        m_nick = snapshot.nick;
+        m_version = snapshot.version;
+        emit connectedChanged();
     }
 
-    m_commandData.append(QByteArray::fromRawData(bytes, commandSize));
+    if(snapshot.gameRunning && snapshot.gameSerial != m_gameSerial) {
+        m_gameSerial = snapshot.gameSerial;
 
-    if(m_currentCommandByte != EVENT_SPLIT_MSG) {
-        //qDebug() << "Parse command" << QString::number(m_currentCommandByte, 16) << "with" << m_commandData.size() << "bytes payload.";
-    }
-
-    // can now fully read the command
-    switch(m_currentCommandByte) {
-    case EVENT_SPLIT_MSG:
-        // do nothing
-        break;
-    case EVENT_GAME_START:
-        parseGameStart();
-        break;
-    case EVENT_PRE_FRAME:
-        parsePreFrame();
-        break;
-    case EVENT_POST_FRAME:
-        parsePostFrame();
-        break;
-    case EVENT_FRAME_START:
-        break;
-    case EVENT_ITEM_UPDATE:
-        break;
-    case EVENT_FRAME_BOOKEND:
-        break;
-    case EVENT_GECKO_LIST:
-        break;
-    case EVENT_GAME_END:
-        parseGameEnd();
-        break;
-    default:
-        qWarning() << "Command" << QString::number(m_currentCommandByte, 16) << "not implemented.";
-        break;
-    }
+        m_gameInfo.reset(new GameInformation(this));
+        m_gameInfo->setInfo(snapshot.gameInfo, snapshot.players);
 
-    if(m_currentCommandByte != EVENT_SPLIT_MSG) {
-        // done reading current command
-        m_commandData.clear();
+        m_gameRunning = true;
+        emit gameInfoChanged();
+        emit gameRunningChanged();
+        emit gameStarted();
     }
-    m_currentCommandByte = 0;
-    delete[] bytes;
-
-    return true;
-}
-
-bool EventParser::parseGameStart()
-{
-    QDataStream stream(m_commandData);
-
-    quint8 version[4];
-    stream.readRawData((char*)&version, 4);
-
-    m_gameInfo.reset(new GameInformation(this));
-    GameInformation &gi = *m_gameInfo;
 
-    gi.version = QString("%1.%2.%3 (%4)").arg(version[0]).arg(version[1]).arg(version[2]).arg(version[3]);
+    // replay the overlay events up to this snapshot in order, then apply its latest state
+    EventDecoder::StatsEventQueue &events = m_decoder->statsEvents();
+    while(!events.isEmpty() && qint32(events.front().serial - snapshot.statsEventSerial) < 0) {
+        const PlayerStatsEvent &event = events.front();
 
-    char gameInfoBlock[312];
-    stream.readRawData(gameInfoBlock, 312);
-
-    QDataStream gameInfoStream(QByteArray(gameInfoBlock, 312));
-    gameInfoStream.skipRawData(0x60);
-
-    for(auto &player: gi.players) {
-        gameInfoStream >> player->charId;
-        gameInfoStream >> player->playerType;
+        if(m_gameInfo && event.gameSerial == m_gameSerial) {
+            PlayerInformation *player = m_gameInfo->players[event.player].data();
+            (event.follower ? player->createFollower() : player)->applyStats(event.stats);
+        }
 
-        gameInfoStream.skipRawData(0x22);
+        events.pop();
     }
 
-    stream >> gi.seed;
-
-    for(auto &player: gi.players) {
-        stream >> player->dashbackFix;
-    }
+    if(m_gameInfo && snapshot.gameSerial == m_gameSerial) {
+        for(int i = 0; i < NUM_PLAYERS; i++) {
+            PlayerInformation *player = m_gameInfo->players[i].data();
+            player->applyStats(snapshot.stats[i]);
 
-    for(auto &player: gi.players) {
-        stream >> player->shieldDropFix;
+            if(snapshot.hasFollower[i]) {
+                player->createFollower()->applyStats(snapshot.followerStats[i]);
+            }
+        }
     }
 
-    QTextCodec *jisCodec = QTextCodec::codecForName("Shift-JIS");
+    if(snapshot.gameEndSerial != m_gameEndSerial) {
+        m_gameEndSerial = snapshot.gameEndSerial;
 
-    if(jisCodec == nullptr) {
-        qWarning() << "Could not find Shift-JIS codec.";
-        jisCodec = QTextCodec::codecForLocale();
-    }
+        const GameEndInfo &end = snapshot.gameEnd;
+        QList<int> playerPlacements(std::begin(end.placements), std::end(end.placements));
 
-    for(auto &player: gi.players) {
-        char rawTag[16];
-        stream.readRawData(rawTag, 16);
-        player->nameTag = jisCodec->toUnicode(rawTag);
+        emit gameEnded(GameEndMethod(end.method), end.lrasPlayer, playerPlacements);
     }
 
-    stream >> gi.isPal >> gi.isFrozenPS >> gi.minorScene >> gi.majorScene;
+    if(!snapshot.gameRunning && m_gameRunning) {
+        m_gameInfo.reset(nullptr);
 
-    for(auto &player: gi.players) {
-        char rawName[31];
-        stream.readRawData(rawName, 31);
-        player->slippiName = jisCodec->toUnicode(rawName);
+        m_gameRunning = false;
+        emit gameInfoChanged();
+        emit gameRunningChanged();
     }
+}
 
-    for(auto &player: gi.players) {
-        char rawCode[10];
-        stream.readRawData(rawCode, 10);
-        QString codeStr = jisCodec->toUnicode(rawCode);
-
-        // replace full-width (Unicode 0xff03) hash with regular (half-width) hash
-        player->slippiCode = codeStr.replace(QChar(0xff03), '#');
-    }
+GameInformation *EventParser::gameInfo() const
+{
+    return m_gameInfo.data();
+}
 
-    for(auto &player: gi.players) {
-        char rawUid[29];
-        stream.readRawData(rawUid, 29);
-        player->slippiUid = QString::fromUtf8(rawUid);
+GameInformation::GameInformation(QObject *parent) : QObject(parent) {
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        players[i].reset(new PlayerInformation(this));
     }
-
-    stream >> gi.languageOption;
-
-    char rawMatchId[51];
-    stream.readRawData(rawMatchId, 51);
-    gi.matchId = QString::fromUtf8(rawMatchId);
-
-    stream >> gi.gameNumber >> gi.tiebreakerNumber;
-
-    m_gameRunning = true;
-    emit gameInfoChanged();
-    emit gameRunningChanged();
-    emit gameStarted();
-
-    return true;
 }
 
-bool EventParser::parsePreFrame()
+void GameInformation::setInfo(const GameInfo &info, const PlayerInfo (&playerInfos)[NUM_PLAYERS])
 {
-    PreFrameData d(m_commandData);
-    PlayerInformation &player = *m_gameInfo->players[d.playerIndex];
-    player.preFrame = d;
+    version = info.version;
+    seed = info.seed;
+    stageId = info.stageId;
+    isPal = info.isPal;
+    isFrozenPS = info.isFrozenPS;
+    minorScene = info.minorScene;
+    majorScene = info.majorScene;
+    languageOption = info.languageOption;
+    matchId = info.matchId;
+    gameNumber = info.gameNumber;
+    tiebreakerNumber = info.tiebreakerNumber;
 
-    player.analyzeFrame();
-
-    return true;
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        players[i]->setInfo(playerInfos[i]);
+    }
 }
 
-bool EventParser::parsePostFrame()
-{
-    PostFrameData d(m_commandData);
-    PlayerInformation &player = *m_gameInfo->players[d.playerIndex];
-    player.postFrame = d;
+PlayerInformation::PlayerInformation(QObject *parent) : QObject(parent) {
 
-    player.analyzeFrame();
+}
 
-    return true;
+void PlayerInformation::setInfo(const PlayerInfo &info)
+{
+    dashbackFix = info.dashbackFix;
+    shieldDropFix = info.shieldDropFix;
+    charId = info.charId;
+    playerType = info.playerType;
+    nameTag = info.nameTag;
+    slippiCode = info.slippiCode;
+    slippiName = info.slippiName;
+    slippiUid = info.slippiUid;
 }
 
-bool PlayerInformation::analyzeFrame()
+PlayerInformation *PlayerInformation::createFollower()
 {
-    if(preFrame.isEmpty || postFrame.isEmpty) {
-        return false;
+    if(!m_follower) {
+        // only carries the stats, the port info stays on the leader
+        m_follower.reset(new PlayerInformation(this));
+        m_follower->charId = charId;
+        m_follower->playerType = playerType;
+        emit followerChanged();
     }
 
-    bool analogTriggerHeld = preFrame.processedButtons.anyTrigger || preFrame.processedButtons.physicalButtons.z;
-    bool isLCancel = analogTriggerHeld;
-    if(isLCancel && !this->isLCancel) {
-        framesSinceLCancel = 0;
-    }
+    return m_follower.data();
+}
 
-    this->isLCancel = isLCancel;
+void PlayerInformation::applyStats(const PlayerStats &stats)
+{
+    setComboCount(stats.comboCount);
+    setLCancelState(LCancelState(stats.lCancelState));
+    setWavedash(stats.wavedashFrame, stats.wavedashAngle);
+    setCycloneBPresses(stats.cycloneBPresses);
 
-    if(isLCancel || framesSinceLCancel > 0) {
-        framesSinceLCancel++;
+    if(framesSinceLCancel != stats.framesSinceLCancel) {
+        framesSinceLCancel = stats.framesSinceLCancel;
         emit lCancelFramesChanged();
     }
 
-    // CliffWait - get 30 intangibility frames
-    if(postFrame.actionStateId == 253 && intangibilityFrames == 0) {
-        intangibilityFrames = 31;
-    }
-
-    if(intangibilityFrames > 0) {
-        intangibilityFrames--;
+    if(intangibilityFrames != stats.intangibilityFrames) {
+        intangibilityFrames = stats.intangibilityFrames;
         emit intangibilityFramesChanged();
     }
 
-    bool falling = postFrame.airborne && postFrame.ySpeedSelf < 0;
-
-    if(falling != isFalling) {
-        framesSinceFall = 0;
-        isFalling = falling;
-    }
-
-    // note: the fastFalling flag is true on the frame after inputting fast fall
-    // thus increment the frames afterwards so frame 1 does not output frame 2
-    if(postFrame.isFastFalling != isFastFalling) {
-        isFastFalling = postFrame.isFastFalling;
+    if(isFastFalling != stats.isFastFalling) {
+        isFastFalling = stats.isFastFalling;
         emit isFastFallingChanged();
     }
 
-    if(falling) {
-        framesSinceFall++;
+    if(framesSinceFall != stats.framesSinceFall) {
+        framesSinceFall = stats.framesSinceFall;
         emit framesSinceFallChanged();
     }
-
-    // LandingFallSpecial - landing lag after free fall or airdodge
-    if(postFrame.actionStateId == 43 && postFrame.actionStateFrameCounter == 0) {
-        // first frame of LandingFallSpecial
-        QVector2D speedVector(postFrame.xSpeedSelfGround, postFrame.ySpeedSelf);
-        qreal wdTiming = qLn(speedVector.length() / 3.1) / qLn(0.9);
-        qreal fractionalPart = qAbs(wdTiming - qRound(wdTiming));
-
-        if(fractionalPart > 0.001) {
-            // not a wavedash if the speed isn't directly influenced by the airdodge (3.1 * 0.9 ^ nFrames)
-            // TODO implement a better detection for this
-            setWavedash(0, 0);
-            qDebug() << "Not a wavedash:" << wdTiming << fractionalPart;
-        }
-        else {
-            float angle = M_PI + qAtan2(postFrame.ySpeedSelf, postFrame.xSpeedSelfGround);
-            if(angle > M_PI_2) {
-                angle = M_PI - angle;
-            }
-
-            setWavedash(qRound(wdTiming), angle * 180 / M_PI);
-        }
-    }
-    else {
-        setWavedash(0, 0);
-    }
-
-    // Luigi aerial down B
-    if(charId == 7 && postFrame.actionStateId == 0x166) {
-        bool isBPress = preFrame.physicalButtons.b && !preFramePrev.physicalButtons.b;
-        float ySpeedDiff = postFramePrev.ySpeedSelf - postFrame.ySpeedSelf;
-
-        // B pressed + vertical speed increased -> press during mash window
-        if(isBPress && ySpeedDiff) {
-            setCycloneBPresses(cycloneBPresses + 1);
-        }
-    }
-    else {
-        setCycloneBPresses(0);
-    }
-
-    setComboCount(postFrame.comboCount);
-    setLCancelState(PlayerInformation::LCancelState(postFrame.lCancelStatus));
-
-    preFramePrev = preFrame;
-    postFramePrev = postFrame;
-
-    preFrame = {};
-    postFrame = {};
-
-    return true;
-}
-
-bool EventParser::parseGameEnd()
-{
-    QDataStream stream(m_commandData);
-
-    quint8 gameEndMethod;
-    qint8 lrasPlayerIndex;
-    QList<int> playerPlacements;
-    stream >> gameEndMethod >> lrasPlayerIndex;
-
-    for(int i = 0; i < NUM_PLAYERS; i++) {
-        qint8 placement;
-        stream >> placement;
-        playerPlacements << placement;
-    }
-
-    emit gameEnded(GameEndMethod(gameEndMethod), lrasPlayerIndex, playerPlacements);
-
-    return true;
-}
-
-void EventParser::resetGameState()
-{
-    // reset state for next game:
-    //m_hasPayloadSizes = false;
-    m_dataBuffer.clear();
-    m_dataStream.device()->reset();
-    m_writeStream.device()->reset();
-    m_availableBytes = 0;
-    m_currentCommandByte = 0;
-    m_gameInfo.reset(nullptr);
-
-    m_gameRunning = false;
-    emit gameInfoChanged();
-    emit gameRunningChanged();
-}
-
-GameInformation *EventParser::gameInfo() const
-{
-    return m_gameInfo.data();
-}
-
-GameInformation::GameInformation(QObject *parent) : QObject(parent) {
-    for(int i = 0; i < NUM_PLAYERS; i++) {
-        players[i].reset(new PlayerInformation(this));
-    }
-}
-
-PlayerInformation::PlayerInformation(QObject *parent) : QObject(parent) {
-
 }
 
 void PlayerInformation::setComboCount(quint32 newComboCount)
@@ -2,14 +2,12 @@
 #define EVENTPARSER_H
 
 #include <QObject>
-#include <QBuffer>
 #include <QMap>
 #include <QVariant>
 #include <QQmlListProperty>
+#include <QSharedPointer>
 
-#include "slippievents.h"
-
-const int NUM_PLAYERS = 4;
+#include "eventdecoder.h"
 
 struct PlayerInformation : public QObject {
     Q_OBJECT
@@ -36,6 +34,9 @@ struct PlayerInformation : public QObject {
     // char specific stats
     Q_PROPERTY(int cycloneBPresses MEMBER cycloneBPresses NOTIFY cycloneBPressesChanged)
 
+    // stats of Nana for Ice Climbers, null until her first frame was analyzed
+    Q_PROPERTY(PlayerInformation *follower READ follower NOTIFY followerChanged)
+
 signals:
     void comboCountChanged();
     void lCancelStateChanged();
@@ -45,6 +46,7 @@ signals:
     void isFastFallingChanged();
     void framesSinceFallChanged();
     void cycloneBPressesChanged();
+    void followerChanged();
 
 public:
     PlayerInformation(QObject *parent = nullptr);
@@ -63,19 +65,19 @@ public:
     void setWavedash(int frame, qreal angle);
     void setCycloneBPresses(int bPresses);
 
-    bool analyzeFrame();
+    void setInfo(const PlayerInfo &info);
+    void applyStats(const PlayerStats &stats);
 
-    // fields set from EventParser
-    PreFrameData preFrame, preFramePrev;
-    PostFrameData postFrame, postFramePrev;
+    PlayerInformation *follower() const { return m_follower.data(); }
+    PlayerInformation *createFollower();
 
     quint32 dashbackFix = Off, shieldDropFix = Off;
     quint8 charId = 0, playerType = Empty;
     QString nameTag, slippiCode, slippiName, slippiUid;
 
 private:
-    // fields set from analyzeFrame()
-    bool isLCancel = false, isFalling = false, isFastFalling = false;
+    // fields set from the analysis results in EventDecoder
+    bool isFastFalling = false;
     int framesSinceLCancel = 0, framesSinceFall = 0;
     quint32 comboCount = 0;
     LCancelState lCancelState = Unknown;
@@ -83,6 +85,8 @@ private:
     int intangibilityFrames = 0;
     qreal wavedashAngle = 0;
     int cycloneBPresses = 0;
+
+    QScopedPointer<PlayerInformation> m_follower;
 };
 Q_DECLARE_METATYPE(PlayerInformation);
 
@@ -90,6 +94,7 @@ struct GameInformation : public QObject {
     Q_OBJECT
     Q_PROPERTY(QString version MEMBER version CONSTANT)
     Q_PROPERTY(quint32 randomSeed MEMBER seed CONSTANT)
+    Q_PROPERTY(quint16 stageId MEMBER stageId CONSTANT)
 
     Q_PROPERTY(PlayerInformation *player1 READ player1 CONSTANT)
     Q_PROPERTY(PlayerInformation *player2 READ player2 CONSTANT)
@@ -110,8 +115,11 @@ struct GameInformation : public QObject {
 public:
     GameInformation(QObject *parent = nullptr);
 
+    void setInfo(const GameInfo &info, const PlayerInfo (&playerInfos)[NUM_PLAYERS]);
+
     QString version;
     quint32 seed = 0;
+    quint16 stageId = 0;
     quint8 isPal = 0, isFrozenPS = 0, minorScene = 0, majorScene = 0;
     quint8 languageOption = 0;
 
@@ -137,29 +145,78 @@ class EventParser : public QObject
 
     Q_PROPERTY(GameInformation *gameInfo READ gameInfo NOTIFY gameInfoChanged)
 
-    // events from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#events
-    enum SlippiEvents {
-        EVENT_SPLIT_MSG     = 0x10,
-        EVENT_PAYLOADS      = 0x35,
-        EVENT_GAME_START    = 0x36,
-        EVENT_PRE_FRAME     = 0x37,
-        EVENT_POST_FRAME    = 0x38,
-        EVENT_GAME_END      = 0x39,
-        EVENT_FRAME_START   = 0x3A,
-        EVENT_ITEM_UPDATE   = 0x3B,
-        EVENT_FRAME_BOOKEND = 0x3c,
-        EVENT_GECKO_LIST    = 0x3D,
-        EVENT_UNKNOWN       = 0x45,
-        EVENT_HIGHEST       = EVENT_UNKNOWN
-    };
+    // how often decoded state is handed over from the decoder thread, interval in ms
+    Q_PROPERTY(EventDecoder::DeliveryMode deliveryMode READ deliveryMode WRITE setDeliveryMode NOTIFY deliveryModeChanged)
+    Q_PROPERTY(int flushInterval READ flushInterval WRITE setFlushInterval NOTIFY deliveryModeChanged)
+
+    // messages per hand-off and time from the first message to the hand-off in microseconds
+    Q_PROPERTY(int lastBatchSize READ lastBatchSize NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(int maxBatchSize READ maxBatchSize NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(qreal averageBatchSize READ averageBatchSize NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(qint64 lastFlushLatency READ lastFlushLatency NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(qint64 maxFlushLatency READ maxFlushLatency NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(qreal averageFlushLatency READ averageFlushLatency NOTIFY deliveryStatsChanged)
+
+    // time from receiving the game start to handing off its first analyzed frame in microseconds
+    Q_PROPERTY(qint64 firstOverlayLatency READ firstOverlayLatency NOTIFY deliveryStatsChanged)
+
+    // when connecting to a running game: ms until the overlay showed the live state, frames replayed until then
+    Q_PROPERTY(qint64 catchUpTime READ catchUpTime NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(int catchUpFrames READ catchUpFrames NOTIFY deliveryStatsChanged)
+
+    // backpressure: snapshots replaced before the GUI picked them up,
+    // fill level high-water mark and drops of the overlay event queue
+    Q_PROPERTY(quint64 droppedSnapshots READ droppedSnapshots NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(int statsEventHighWaterMark READ statsEventHighWaterMark NOTIFY deliveryStatsChanged)
+    Q_PROPERTY(quint64 droppedStatsEvents READ droppedStatsEvents NOTIFY deliveryStatsChanged)
+
+    // frames resent by Dolphin after rollbacks in online play, see RollbackStats
+    Q_PROPERTY(int rollbacks READ rollbacks NOTIFY rollbackStatsChanged)
+    Q_PROPERTY(int reanalyzedFrames READ reanalyzedFrames NOTIFY rollbackStatsChanged)
+    Q_PROPERTY(int lostRollbacks READ lostRollbacks NOTIFY rollbackStatsChanged)
+    Q_PROPERTY(int maxRollbackDepth READ maxRollbackDepth NOTIFY rollbackStatsChanged)
+    Q_PROPERTY(qint64 reanalysisTime READ reanalysisTime NOTIFY rollbackStatsChanged)
+
 public:
     explicit EventParser(QObject *parent = nullptr);
 
+    // does the actual work, can be moved to another thread. see DolphinConnection::setParser()
+    QSharedPointer<EventDecoder> decoder() const;
+
+    // compatibility wrapper for messages that were already parsed from JSON
     Q_INVOKABLE void parseSlippiMessage(const QVariantMap &event);
+
+    // drops the game state and cursors, also after the connection was lost and is not resumed
     Q_INVOKABLE void disconnnect();
 
     GameInformation *gameInfo() const;
 
+    EventDecoder::DeliveryMode deliveryMode() const;
+    void setDeliveryMode(EventDecoder::DeliveryMode mode);
+
+    int flushInterval() const;
+    void setFlushInterval(int flushInterval);
+
+    int lastBatchSize() const { return m_deliveryStats.lastBatchSize; }
+    int maxBatchSize() const { return m_deliveryStats.maxBatchSize; }
+    qreal averageBatchSize() const;
+    qint64 lastFlushLatency() const { return m_deliveryStats.lastFlushLatency; }
+    qint64 maxFlushLatency() const { return m_deliveryStats.maxFlushLatency; }
+    qreal averageFlushLatency() const;
+    qint64 firstOverlayLatency() const { return m_deliveryStats.firstOverlayLatency; }
+    qint64 catchUpTime() const { return m_deliveryStats.catchUpTime; }
+    int catchUpFrames() const { return m_deliveryStats.catchUpFrames; }
+
+    quint64 droppedSnapshots() const;
+    int statsEventHighWaterMark() const;
+    quint64 droppedStatsEvents() const;
+
+    int rollbacks() const { return m_rollbackStats.rollbacks; }
+    int reanalyzedFrames() const { return m_rollbackStats.reanalyzedFrames; }
+    int lostRollbacks() const { return m_rollbackStats.lostRollbacks; }
+    int maxRollbackDepth() const { return m_rollbackStats.maxDepth; }
+    qint64 reanalysisTime() const { return m_rollbackStats.reanalysisTime; }
+
     enum GameEndMethod {
         Unresolved = 0, Resolved = 3,
         Time = 1, Game = 2, NoContext = 7
@@ -174,37 +231,31 @@ signals:
     void gameStarted();
     void gameEnded(EventParser::GameEndMethod endMethod, int lrasPlayer, QList<int> playerPlacements);
 
-private:
-    void parseGameEvent(int cursor, int nextCursor, const QByteArray &payload);
+    void deliveryModeChanged();
+    void deliveryStatsChanged();
+    void rollbackStatsChanged();
 
-    void parsePayloadSizes();
-    bool parseCommand();
-    bool parseGameStart();
+private slots:
+    // picks up the latest snapshot published by the decoder
+    void updateSnapshot();
+
+private:
+    void updateDeliveryMode();
 
-    bool parsePreFrame();
-    bool parsePostFrame();
+    QSharedPointer<EventDecoder> m_decoder;
 
-    bool parseGameEnd();
-    void resetGameState();
+    EventDecoder::DeliveryMode m_deliveryMode = EventDecoder::PerFrame;
+    int m_flushInterval = 16;
+    DeliveryStats m_deliveryStats;
+    RollbackStats m_rollbackStats;
+    quint64 m_takenSnapshots = 0;
 
     QString m_nick;
     QString m_version;
 
-    bool m_connected;
-    bool m_gameRunning;
-
-    int m_currentCursor = -1, m_nextCursor = -1;
-
-    bool m_hasPayloadSizes = false;
-    quint16 m_payloadSizes[EVENT_HIGHEST + 1] = { 0 };
-
-    quint8 m_currentCommandByte = 0;
-
-    QByteArray m_dataBuffer;
-    QDataStream m_dataStream, m_writeStream;
-    uint m_availableBytes = 0;
-
-    QByteArray m_commandData;
+    bool m_connected = false;
+    bool m_gameRunning = false;
+    quint32 m_gameSerial = 0, m_gameEndSerial = 0;
 
     QScopedPointer<GameInformation> m_gameInfo;
 };
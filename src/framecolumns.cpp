@@ -0,0 +1,218 @@
+#include "framecolumns.h"
+#include "cpufeatures.h"
+#include "eventdecoder.h"
+#include "slippieventlayout.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+#if defined(Q_PROCESSOR_X86)
+#include <immintrin.h>
+#define FRAMECOLUMNS_X86
+#endif
+
+#if defined(FRAMECOLUMNS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FRAMECOLUMNS_TARGET(arch) __attribute__((target(arch)))
+#else
+#define FRAMECOLUMNS_TARGET(arch)
+#endif
+
+namespace {
+
+using namespace EventLayout;
+
+// the big-endian 32 bit word at base + offsets[i] + field into the i-th 4 bytes of out
+void gatherScalar(const uchar *base, const qint32 *offsets, qsizetype count, qsizetype field, uchar *out)
+{
+    for(qsizetype i = 0; i < count; i++) {
+        quint32 word = qFromBigEndian<quint32>(base + offsets[i] + field);
+        std::memcpy(out + 4 * i, &word, 4);
+    }
+}
+
+#if defined(FRAMECOLUMNS_X86)
+
+FRAMECOLUMNS_TARGET("avx2")
+void gatherAvx2(const uchar *base, const qint32 *offsets, qsizetype count, qsizetype field, uchar *out)
+{
+    const __m256i byteSwap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const int *fieldBase = reinterpret_cast<const int *>(base + field);
+
+    // 8 events per iteration
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + i));
+        __m256i words = _mm256_i32gather_epi32(fieldBase, index, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 4 * i), _mm256_shuffle_epi8(words, byteSwap));
+    }
+
+    gatherScalar(base, offsets + i, count - i, field, out + 4 * i);
+}
+
+#endif // FRAMECOLUMNS_X86
+
+using GatherFunction = void (*)(const uchar *, const qint32 *, qsizetype, qsizetype, uchar *);
+
+GatherFunction selectGather()
+{
+#if defined(FRAMECOLUMNS_X86)
+    if(CpuFeatures::level() == CpuFeatures::Level::Avx2) {
+        return gatherAvx2;
+    }
+#endif
+    return gatherScalar;
+}
+
+void gather(const uchar *base, const QVector<qint32> &offsets, qsizetype field, uchar *out)
+{
+    static const GatherFunction function = selectGather();
+
+    function(base, offsets.constData(), offsets.size(), field, out);
+}
+
+// a 4 byte field, zero if the payload is too short for it
+template<typename T>
+void gatherColumn(const uchar *base, const QVector<qint32> &offsets, qsizetype field, qsizetype payloadSize,
+                  QVector<T> &column)
+{
+    static_assert(sizeof(T) == 4, "use gatherColumn16()");
+
+    column.resize(offsets.size());
+    if(field + 4 > payloadSize) {
+        column.fill(0);
+        return;
+    }
+
+    gather(base, offsets, field, reinterpret_cast<uchar *>(column.data()));
+}
+
+// reads the word that ends with the 2 byte field, so the reads stay inside the command
+void gatherColumn16(const uchar *base, const QVector<qint32> &offsets, qsizetype field, qsizetype payloadSize,
+                    QVector<quint16> &column, QVector<quint32> &scratch)
+{
+    column.resize(offsets.size());
+    if(field + 2 > payloadSize) {
+        column.fill(0);
+        return;
+    }
+
+    scratch.resize(offsets.size());
+    gather(base, offsets, field - 2, reinterpret_cast<uchar *>(scratch.data()));
+
+    for(qsizetype i = 0; i < scratch.size(); i++) {
+        column[i] = quint16(scratch[i]);
+    }
+}
+
+} // namespace
+
+bool FrameColumns::decode(QByteArrayView events)
+{
+    // the gathers use 32 bit offsets
+    if(events.size() > std::numeric_limits<qint32>::max()) {
+        qWarning() << "Replay too large for the columnar decoder:" << events.size() << "bytes";
+        return false;
+    }
+
+    for(int c = 0; c < NUM_CHARACTERS; c++) {
+        m_preOffsets[c].resize(0);
+        m_postOffsets[c].resize(0);
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(events.data());
+
+    quint16 payloadSizes[256] = { 0 };
+    bool hasGameStart = false;
+    int skippedFrames = 0;
+    m_version = 0;
+
+    // one pass over the commands, only the frame number, port and follower flag of the frame events are read
+    forEachCommand(events, payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        const uchar *command = reinterpret_cast<const uchar *>(payload.data());
+
+        if(commandByte == EventDecoder::EVENT_GAME_START) {
+            m_version = replayVersion(command[0], command[1], command[2]);
+            hasGameStart = true;
+        }
+        else if(commandByte == EventDecoder::EVENT_PRE_FRAME || commandByte == EventDecoder::EVENT_POST_FRAME) {
+            // same offsets in both events
+            qint32 frame = qFromBigEndian<qint32>(command + PreFrame::FrameNumber) - FIRST_FRAME;
+            quint8 playerIndex = command[PreFrame::PlayerIndex];
+
+            // every frame sends a pre frame event per character, a frame number beyond that is corrupt
+            // and must not size the offsets
+            qsizetype maxFrames = events.size() / (payloadSizes[EventDecoder::EVENT_PRE_FRAME] + 1);
+            if(frame >= maxFrames) {
+                skippedFrames++;
+            }
+            else if(frame >= 0 && playerIndex < NUM_PLAYERS) {
+                int c = index(playerIndex, command[PreFrame::IsFollower] != 0);
+                QVector<qint32> &offsets = commandByte == EventDecoder::EVENT_PRE_FRAME ? m_preOffsets[c] : m_postOffsets[c];
+
+                if(offsets.size() <= frame) {
+                    offsets.resize(frame + 1, -1);
+                }
+
+                // a frame that is resent after a rollback replaces the earlier one
+                offsets[frame] = qint32(command - data);
+            }
+        }
+    });
+
+    if(skippedFrames > 0) {
+        qWarning() << "Skipped" << skippedFrames << "frame events with a frame number beyond the end of the replay";
+    }
+
+    qsizetype preSize = payloadSizes[EventDecoder::EVENT_PRE_FRAME];
+    qsizetype postSize = payloadSizes[EventDecoder::EVENT_POST_FRAME];
+
+    m_hasSpeeds = m_version >= replayVersion(3, 5, 0) && PostFrame::XSpeedSelfGround + 4 <= postSize;
+    qsizetype speedSize = m_hasSpeeds ? postSize : 0;
+
+    for(int c = 0; c < NUM_CHARACTERS; c++) {
+        Character &character = m_characters[c];
+        const QVector<qint32> &pre = m_preOffsets[c], &post = m_postOffsets[c];
+
+        character.frameNumber.resize(0);
+        m_gatherPre.resize(0);
+        m_gatherPost.resize(0);
+
+        qsizetype frames = qMin(pre.size(), post.size());
+        for(qsizetype frame = 0; frame < frames; frame++) {
+            if(pre[frame] >= 0 && post[frame] >= 0) {
+                character.frameNumber.append(qint32(frame) + FIRST_FRAME);
+                m_gatherPre.append(pre[frame]);
+                m_gatherPost.append(post[frame]);
+            }
+        }
+
+        gatherColumn(data, m_gatherPre, PreFrame::ProcessedButtons, preSize, character.processedButtons);
+        gatherColumn(data, m_gatherPre, PreFrame::JoyStickX, preSize, character.joyStickX);
+        gatherColumn(data, m_gatherPre, PreFrame::JoyStickY, preSize, character.joyStickY);
+
+        gatherColumn16(data, m_gatherPost, PostFrame::ActionStateId, postSize, character.actionStateId, m_scratch);
+        gatherColumn(data, m_gatherPost, PostFrame::PosX, postSize, character.posX);
+        gatherColumn(data, m_gatherPost, PostFrame::PosY, postSize, character.posY);
+        gatherColumn(data, m_gatherPost, PostFrame::Percent, postSize, character.percent);
+
+        gatherColumn(data, m_gatherPost, PostFrame::XSpeedSelfAir, speedSize, character.xSpeedSelfAir);
+        gatherColumn(data, m_gatherPost, PostFrame::YSpeedSelf, speedSize, character.ySpeedSelf);
+        gatherColumn(data, m_gatherPost, PostFrame::XSpeedSelfGround, speedSize, character.xSpeedSelfGround);
+    }
+
+    return hasGameStart;
+}
+
+qsizetype FrameColumns::frameCount() const
+{
+    qsizetype frames = 0;
+    for(const Character &character : m_characters) {
+        frames = qMax(frames, character.size());
+    }
+    return frames;
+}
@@ -0,0 +1,62 @@
+#ifndef FRAMECOLUMNS_H
+#define FRAMECOLUMNS_H
+
+#include <QByteArrayView>
+#include <QVector>
+
+#include "gamestate.h"
+
+// the frame events of a whole replay as one array per field and character, for analyses that
+// run over complete games. a pass over the commands finds the pre and post frame events, then
+// every column is filled by a gather over those offsets, with AVX2 when the CPU supports it
+class FrameColumns
+{
+public:
+    // leader and follower of every port, see index()
+    static const int NUM_CHARACTERS = NUM_PLAYERS * 2;
+    static int index(quint8 playerIndex, bool isFollower) { return playerIndex * 2 + (isFollower ? 1 : 0); }
+
+    struct Character {
+        // frames with both a pre and a post frame in order, a frame that was rolled back is
+        // only there once with the data that was sent last
+        QVector<qint32> frameNumber;
+
+        // pre frame
+        QVector<quint32> processedButtons;
+        QVector<float> joyStickX, joyStickY;
+
+        // post frame
+        QVector<quint16> actionStateId;
+        QVector<float> posX, posY, percent;
+        QVector<float> xSpeedSelfAir, ySpeedSelf, xSpeedSelfGround; // zero before 3.5.0
+
+        qsizetype size() const { return frameNumber.size(); }
+        bool isEmpty() const { return frameNumber.isEmpty(); }
+    };
+
+    // raw events as in EventDecoder::parseEvents(), keeps the allocations of a previous decode.
+    // returns false if there is no game start
+    bool decode(QByteArrayView events);
+
+    quint32 version() const { return m_version; }
+    bool hasSpeeds() const { return m_hasSpeeds; }
+
+    const Character &character(int index) const { return m_characters[index]; }
+
+    // number of frames of the character with the most frames
+    qsizetype frameCount() const;
+
+private:
+    quint32 m_version = 0;
+    bool m_hasSpeeds = false;
+    Character m_characters[NUM_CHARACTERS];
+
+    // offsets of the command data from the start of the events, by frame number and character
+    QVector<qint32> m_preOffsets[NUM_CHARACTERS], m_postOffsets[NUM_CHARACTERS];
+
+    // offsets of the frames in the columns
+    QVector<qint32> m_gatherPre, m_gatherPost;
+    QVector<quint32> m_scratch;
+};
+
+#endif // FRAMECOLUMNS_H
@@ -0,0 +1,112 @@
+#include "gamestate.h"
+
+#include <QDebug>
+#include <QtMath>
+
+#include <cmath>
+
+bool PlayerStats::isOverlayEvent(const PlayerStats &previous) const
+{
+    return comboCount != previous.comboCount ||
+           lCancelState != previous.lCancelState ||
+           (wavedashFrame != previous.wavedashFrame && wavedashFrame > 0) ||
+           cycloneBPresses != previous.cycloneBPresses;
+}
+
+bool CharacterState::analyzeFrame(quint8 charId)
+{
+    if(preFrame.isEmpty() || postFrame.isEmpty()) {
+        return false;
+    }
+
+    bool analogTriggerHeld = preFrame.isProcessed(PreFrameData::AnyTrigger) || preFrame.isProcessed(PreFrameData::Z);
+    bool isLCancel = analogTriggerHeld;
+    if(isLCancel && !this->isLCancel) {
+        stats.framesSinceLCancel = 0;
+    }
+
+    this->isLCancel = isLCancel;
+
+    if(isLCancel || stats.framesSinceLCancel > 0) {
+        stats.framesSinceLCancel++;
+    }
+
+    // CliffWait - get 30 intangibility frames
+    if(postFrame.actionStateId == 253 && stats.intangibilityFrames == 0) {
+        stats.intangibilityFrames = 31;
+    }
+
+    if(stats.intangibilityFrames > 0) {
+        stats.intangibilityFrames--;
+    }
+
+    bool falling = postFrame.airborne && postFrame.ySpeedSelf < 0;
+
+    if(falling != isFalling) {
+        stats.framesSinceFall = 0;
+        isFalling = falling;
+    }
+
+    // note: the fastFalling flag is true on the frame after inputting fast fall
+    // thus increment the frames afterwards so frame 1 does not output frame 2
+    stats.isFastFalling = postFrame.isFastFalling();
+
+    if(falling) {
+        stats.framesSinceFall++;
+    }
+
+    // LandingFallSpecial - landing lag after free fall or airdodge, the speeds are sent since 3.5.0
+    bool hasSpeeds = postFrame.has(PostFrameData::Field::XSpeedSelfGround);
+    if(hasSpeeds && postFrame.actionStateId == 43 && postFrame.actionStateFrameCounter == 0) {
+        // first frame of LandingFallSpecial
+        qreal speed = std::hypot(postFrame.xSpeedSelfGround, postFrame.ySpeedSelf);
+        qreal wdTiming = qLn(speed / 3.1) / qLn(0.9);
+        qreal fractionalPart = qAbs(wdTiming - qRound(wdTiming));
+
+        if(fractionalPart > 0.001) {
+            // not a wavedash if the speed isn't directly influenced by the airdodge (3.1 * 0.9 ^ nFrames)
+            // TODO implement a better detection for this
+            stats.wavedashFrame = 0;
+            stats.wavedashAngle = 0;
+            qDebug() << "Not a wavedash:" << wdTiming << fractionalPart;
+        }
+        else {
+            float angle = M_PI + qAtan2(postFrame.ySpeedSelf, postFrame.xSpeedSelfGround);
+            if(angle > M_PI_2) {
+                angle = M_PI - angle;
+            }
+
+            stats.wavedashFrame = qRound(wdTiming);
+            stats.wavedashAngle = angle * 180 / M_PI;
+        }
+    }
+    else {
+        stats.wavedashFrame = 0;
+        stats.wavedashAngle = 0;
+    }
+
+    // Luigi aerial down B
+    if(charId == 7 && postFrame.actionStateId == 0x166) {
+        bool isBPress = preFrame.isPressed(PreFrameData::B) && !preFramePrev.isPressed(PreFrameData::B);
+        float ySpeedDiff = postFramePrev.ySpeedSelf - postFrame.ySpeedSelf;
+
+        // B pressed + vertical speed increased -> press during mash window
+        if(isBPress && ySpeedDiff) {
+            stats.cycloneBPresses++;
+        }
+    }
+    else {
+        stats.cycloneBPresses = 0;
+    }
+
+    stats.comboCount = postFrame.comboCount;
+    stats.lCancelState = postFrame.lCancelStatus;
+
+    preFramePrev = preFrame;
+    postFramePrev = postFrame;
+
+    preFrame = {};
+    postFrame = {};
+
+    return true;
+}
@@ -0,0 +1,138 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include <QString>
+
+#include "slippievents.h"
+
+const int NUM_PLAYERS = 4;
+
+// frame number of the first frame, the countdown before the game starts at frame 0
+const qint32 FIRST_FRAME = -123;
+
+// values from the game start event, see PlayerInformation for the enums
+struct PlayerInfo {
+    quint32 dashbackFix = 0, shieldDropFix = 0;
+    quint8 charId = 0, playerType = 3; // PlayerInformation::Empty
+    QString nameTag, slippiCode, slippiName, slippiUid;
+};
+
+struct GameInfo {
+    QString version;
+    quint32 seed = 0;
+    quint16 stageId = 0;
+    quint8 isPal = 0, isFrozenPS = 0, minorScene = 0, majorScene = 0;
+    quint8 languageOption = 0;
+
+    QString matchId;
+    quint32 gameNumber = 0, tiebreakerNumber = 0;
+};
+
+// results of analyzeFrame() that are shown in the overlays
+struct PlayerStats {
+    quint32 comboCount = 0;
+    quint8 lCancelState = 0; // PlayerInformation::LCancelState
+    int framesSinceLCancel = 0, framesSinceFall = 0;
+    int intangibilityFrames = 0;
+    int wavedashFrame = 0;
+    qreal wavedashAngle = 0;
+    bool isFastFalling = false;
+    int cycloneBPresses = 0;
+
+    // true if the change from previous triggers an overlay, e.g. a wavedash or a new combo count
+    bool isOverlayEvent(const PlayerStats &previous) const;
+};
+
+// stats of a frame with an overlay event, queued so the GUI sees each of them
+// even if it only picks up every n-th snapshot
+struct PlayerStatsEvent {
+    quint32 serial = 0;     // incremented for every event, also the ones that are dropped
+    quint32 gameSerial = 0;
+    quint8 player = 0;
+    bool follower = false;
+    PlayerStats stats;
+};
+
+// one character of a port, the follower is Nana for Ice Climbers
+struct CharacterState {
+    PlayerStats stats;
+
+    // fields set from EventDecoder
+    PreFrameData preFrame, preFramePrev;
+    PostFrameData postFrame, postFramePrev;
+
+    // internal state of analyzeFrame()
+    bool isLCancel = false, isFalling = false;
+
+    // charId from PlayerInfo
+    bool analyzeFrame(quint8 charId);
+};
+
+struct PlayerState {
+    PlayerInfo info;
+
+    // both slots are always there, the follower is used once its first frame arrives
+    CharacterState leader, follower;
+    bool hasFollower = false;
+
+    CharacterState &character(bool isFollower) { return isFollower ? follower : leader; }
+};
+
+struct GameState {
+    GameInfo info;
+    PlayerState players[NUM_PLAYERS];
+};
+
+struct GameEndInfo {
+    quint8 method = 0; // EventParser::GameEndMethod
+    qint8 lrasPlayer = -1;
+    qint8 placements[NUM_PLAYERS] = { -1, -1, -1, -1 };
+};
+
+// counters for the coalescing of messages into published snapshots, latencies in microseconds
+struct DeliveryStats {
+    quint32 flushes = 0;
+    quint32 lastBatchSize = 0, maxBatchSize = 0;
+    quint64 totalMessages = 0;
+    qint64 lastFlushLatency = 0, maxFlushLatency = 0, totalFlushLatency = 0;
+    qint64 firstOverlayLatency = 0; // from the last game start to its first analyzed frame
+
+    // when connecting to a running game: ms from the connect reply to the first live snapshot
+    // and the number of frames that were already played
+    qint64 catchUpTime = 0;
+    quint32 catchUpFrames = 0;
+};
+
+// frames that Dolphin sent again after a rollback in online play
+struct RollbackStats {
+    quint32 rollbacks = 0;          // times the frame number went back
+    quint32 reanalyzedFrames = 0;
+    quint32 lostRollbacks = 0;      // went back further than the history, analyzed as new frames
+    int maxDepth = 0;               // frames rolled back at once
+    qint64 reanalysisTime = 0;      // microseconds spent on re-analyzed frames
+};
+
+// copy of everything the GUI shows, published by EventDecoder after each processed batch of messages
+struct GameSnapshot {
+    bool connected = false;
+    QString nick, version;
+
+    bool gameRunning = false;
+    quint32 gameSerial = 0;     // incremented on every game start
+    quint32 gameEndSerial = 0;  // set to gameSerial when the game end event was received
+
+    GameInfo gameInfo;
+    PlayerInfo players[NUM_PLAYERS];
+    PlayerStats stats[NUM_PLAYERS];
+    PlayerStats followerStats[NUM_PLAYERS];
+    bool hasFollower[NUM_PLAYERS] = {};
+    GameEndInfo gameEnd;
+
+    DeliveryStats delivery;
+    RollbackStats rollback;
+
+    // PlayerStatsEvent::serial of the next event, all events before it are included in this snapshot
+    quint32 statsEventSerial = 0;
+};
+
+#endif // GAMESTATE_H
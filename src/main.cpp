@@ -8,7 +8,9 @@
 #include <QMutex>
 
 #include "dolphinconnection.h"
+#include "dolphinconnectionmanager.h"
 #include "eventparser.h"
+#include "replayreader.h"
 #include "enet/enet.h"
 
 // uncomment this line to add the Live Client Module and use live reloading with your custom C++ code
@@ -85,8 +87,11 @@ int main(int argc, char *argv[])
   // also see the .pro file for more details
   //felgo.setMainQmlFileName(QStringLiteral("qrc:/qml/Main.qml"));
 
-  qmlRegisterType<DolphinConnection>("SlippiLive", 1, 0, "DolphinConnection");
+  qmlRegisterType<DolphinConnectionManager>("SlippiLive", 1, 0, "DolphinConnectionManager");
+  qmlRegisterUncreatableType<DolphinConnection>("SlippiLive", 1, 0, "DolphinConnection", "Created by DolphinConnectionManager.addConnection()");
   qmlRegisterType<EventParser>("SlippiLive", 1, 0, "SlippiEventParser");
+  qmlRegisterType<ReplayReader>("SlippiLive", 1, 0, "ReplayReader");
+  qmlRegisterUncreatableType<EventDecoder>("SlippiLive", 1, 0, "SlippiEventDecoder", "Only used for EventParser.deliveryMode");
   qmlRegisterUncreatableType<GameInformation>("SlippiLive", 1, 0, "GameInformation", "Only used for EventParser.gameInfo");
   qmlRegisterUncreatableType<PlayerInformation>("SlippiLive", 1, 0, "PlayerInformation", "Only used for EventParser.gameInfo.playerN");
 
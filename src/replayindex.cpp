@@ -0,0 +1,421 @@
+#include "replayindex.h"
+#include "eventdecoder.h"
+#include "slippieventlayout.h"
+#include "slpfile.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// index file: magic, format, entry count, entries
+const quint32 INDEX_MAGIC = 0x534c5049; // "SLPI"
+const quint32 INDEX_FORMAT = 1;
+
+void writeIndexEntry(QDataStream &stream, const ReplayIndexEntry &entry)
+{
+    const GameInfo &gi = entry.info;
+
+    stream << entry.fileName << entry.size << entry.modified << entry.valid << entry.replayVersion
+           << gi.version << gi.seed << gi.stageId << gi.isPal << gi.isFrozenPS << gi.minorScene << gi.majorScene
+           << gi.languageOption << gi.matchId << gi.gameNumber << gi.tiebreakerNumber;
+
+    for(const PlayerInfo &player : entry.players) {
+        stream << player.dashbackFix << player.shieldDropFix << player.charId << player.playerType
+               << player.nameTag << player.slippiCode << player.slippiName << player.slippiUid;
+    }
+
+    stream << entry.startAt << entry.playedOn << entry.lastFrame;
+}
+
+void readIndexEntry(QDataStream &stream, ReplayIndexEntry &entry)
+{
+    GameInfo &gi = entry.info;
+
+    stream >> entry.fileName >> entry.size >> entry.modified >> entry.valid >> entry.replayVersion
+           >> gi.version >> gi.seed >> gi.stageId >> gi.isPal >> gi.isFrozenPS >> gi.minorScene >> gi.majorScene
+           >> gi.languageOption >> gi.matchId >> gi.gameNumber >> gi.tiebreakerNumber;
+
+    for(PlayerInfo &player : entry.players) {
+        stream >> player.dashbackFix >> player.shieldDropFix >> player.charId >> player.playerType
+               >> player.nameTag >> player.slippiCode >> player.slippiName >> player.slippiUid;
+    }
+
+    stream >> entry.startAt >> entry.playedOn >> entry.lastFrame;
+}
+
+// the data of the game start event, which follows the payload sizes at the start of the events.
+// if it is cut off, requiredSize is set to the number of event bytes needed for it
+QByteArrayView gameStartCommand(QByteArrayView events, qsizetype &requiredSize)
+{
+    requiredSize = 0;
+
+    if(events.size() < 2 || quint8(events[0]) != EventDecoder::EVENT_PAYLOADS) {
+        return QByteArrayView();
+    }
+
+    // the game start directly follows the payload sizes
+    quint16 payloadSizes[EventDecoder::EVENT_HIGHEST + 1] = { 0 };
+    QByteArrayView gameStart;
+
+    CommandWalk walk = forEachCommand(events, payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        if(commandByte == EventDecoder::EVENT_GAME_START) {
+            gameStart = payload;
+        }
+        return commandByte == EventDecoder::EVENT_PAYLOADS;
+    });
+
+    if(walk.status == CommandWalk::Incomplete || walk.status == CommandWalk::End) {
+        // a cut off payload sizes event needs more than the head, a cut off or missing game start its whole payload
+        requiredSize = walk.pos == 0 ? events.size() + 1 : walk.pos + 1 + payloadSizes[EventDecoder::EVENT_GAME_START];
+    }
+
+    return gameStart;
+}
+
+}
+
+struct ReplayIndex::Scan {
+    // every replay in the directory, the new and changed ones are filled by the pool
+    QVector<ReplayIndexEntry> entries;
+    std::atomic<int> remaining = 0;
+    int read = 0, added = 0;
+};
+
+ReplayIndex::ReplayIndex(QObject *parent)
+    : QObject{parent}
+{
+    m_rescanTimer.setSingleShot(true);
+    m_rescanTimer.setInterval(RESCAN_DELAY);
+
+    connect(&m_rescanTimer, &QTimer::timeout, this, &ReplayIndex::rescan);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        m_rescanTimer.start();
+    });
+}
+
+ReplayIndex::~ReplayIndex()
+{
+    close();
+}
+
+bool ReplayIndex::open(const QString &directory, const QString &indexFile)
+{
+    close();
+
+    QFileInfo info(directory);
+    if(!info.isDir()) {
+        qWarning() << "Replay directory" << directory << "does not exist.";
+        return false;
+    }
+
+    m_directory = info.absoluteFilePath();
+    m_indexFile = indexFile;
+
+    if(m_indexFile.isEmpty()) {
+        QByteArray hash = QCryptographicHash::hash(m_directory.toUtf8(), QCryptographicHash::Md5).toHex();
+        QDir cache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+        m_indexFile = cache.filePath(QString("replays-%1.slpindex").arg(QString::fromLatin1(hash)));
+    }
+
+    load();
+    rescan();
+
+    return true;
+}
+
+void ReplayIndex::close()
+{
+    m_rescanTimer.stop();
+
+    // a running scan is dropped
+    m_pool.clear();
+    m_pool.waitForDone();
+    m_scan.reset();
+    m_rescanPending = false;
+
+    if(!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+
+    m_entries.clear();
+    m_entryIndex.clear();
+    m_directory.clear();
+    m_indexFile.clear();
+}
+
+void ReplayIndex::rescan()
+{
+    if(m_directory.isEmpty()) {
+        return;
+    }
+
+    if(m_scan) {
+        m_rescanPending = true;
+        return;
+    }
+
+    QSharedPointer<Scan> scan(new Scan);
+    m_scan = scan;
+
+    QStringList directories = { m_directory };
+    QVector<qsizetype> changed;
+
+    // the file infos come from the directory listing, so unchanged files cost no extra file system call
+    QDirIterator it(m_directory, { "*.slp" }, QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+
+        if(info.isDir()) {
+            directories << info.absoluteFilePath();
+            continue;
+        }
+
+        QString fileName = info.absoluteFilePath();
+        auto known = m_entryIndex.constFind(fileName);
+
+        if(known != m_entryIndex.constEnd()) {
+            const ReplayIndexEntry &entry = m_entries[*known];
+            if(entry.size == info.size() && entry.modified == info.lastModified().toMSecsSinceEpoch()) {
+                scan->entries.append(entry);
+                continue;
+            }
+        }
+        else {
+            scan->added++;
+        }
+
+        ReplayIndexEntry entry;
+        entry.fileName = fileName;
+
+        changed.append(scan->entries.size());
+        scan->entries.append(entry);
+    }
+
+    updateWatchedDirectories(directories);
+
+    scan->read = changed.size();
+    scan->remaining = changed.size();
+
+    if(changed.isEmpty()) {
+        finishScan(scan);
+        return;
+    }
+
+    // one file per task, each task writes only its own entry
+    ReplayIndexEntry *entries = scan->entries.data();
+    for(qsizetype i : std::as_const(changed)) {
+        m_pool.start([this, scan, entries, i]() {
+            entries[i] = readEntry(QFileInfo(entries[i].fileName));
+
+            if(--scan->remaining == 0) {
+                QMetaObject::invokeMethod(this, [this, scan]() {
+                    finishScan(scan);
+                }, Qt::QueuedConnection);
+            }
+        });
+    }
+}
+
+void ReplayIndex::waitForScan()
+{
+    // finishing can start the next scan if a rescan was requested meanwhile
+    while(m_scan) {
+        m_pool.waitForDone();
+        finishScan(m_scan);
+    }
+}
+
+ReplayIndexEntry ReplayIndex::readEntry(const QFileInfo &file)
+{
+    ReplayIndexEntry entry;
+    entry.fileName = file.absoluteFilePath();
+    entry.size = file.size();
+    entry.modified = file.lastModified().toMSecsSinceEpoch();
+
+    SlpFile slp;
+    if(!slp.open(entry.fileName, HEAD_SIZE)) {
+        qWarning().noquote() << "Could not index" << entry.fileName << ":" << slp.errorString();
+        return entry;
+    }
+
+    qsizetype requiredSize = 0;
+    QByteArrayView command = gameStartCommand(slp.rawEvents(), requiredSize);
+
+    if(command.isEmpty() && requiredSize > slp.rawEvents().size()) {
+        // a game start that does not fit into the head
+        if(slp.open(entry.fileName)) {
+            command = gameStartCommand(slp.rawEvents(), requiredSize);
+        }
+    }
+
+    if(command.isEmpty()) {
+        return entry;
+    }
+
+    GameState game;
+    entry.replayVersion = EventDecoder::readGameStart(command, game);
+    entry.info = game.info;
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        entry.players[i] = game.players[i].info;
+    }
+    entry.valid = true;
+
+    QVariantMap metadata = slp.readMetadata();
+    entry.startAt = metadata.value("startAt").toString();
+    entry.playedOn = metadata.value("playedOn").toString();
+    entry.lastFrame = metadata.value("lastFrame").toInt();
+
+    // replays before 3.9.0 only have the netplay names and codes in the metadata
+    QVariantMap players = metadata.value("players").toMap();
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        QVariantMap names = players.value(QString::number(i)).toMap().value("names").toMap();
+        PlayerInfo &player = entry.players[i];
+
+        if(player.slippiName.isEmpty()) {
+            player.slippiName = names.value("netplay").toString();
+        }
+        if(player.slippiCode.isEmpty()) {
+            player.slippiCode = names.value("code").toString();
+        }
+    }
+
+    return entry;
+}
+
+void ReplayIndex::finishScan(QSharedPointer<Scan> scan)
+{
+    // already finished by waitForScan() or dropped by close()
+    if(scan != m_scan) {
+        return;
+    }
+
+    m_scan.reset();
+
+    int removed = m_entries.size() - (scan->entries.size() - scan->added);
+
+    m_entries = scan->entries;
+    std::sort(m_entries.begin(), m_entries.end(), [](const ReplayIndexEntry &a, const ReplayIndexEntry &b) {
+        return a.fileName < b.fileName;
+    });
+    updateEntryIndex();
+
+    if(scan->read > 0 || removed > 0) {
+        save();
+    }
+
+    emit scanFinished(scan->read, removed);
+
+    if(m_rescanPending) {
+        m_rescanPending = false;
+        rescan();
+    }
+}
+
+void ReplayIndex::updateWatchedDirectories(const QStringList &directories)
+{
+    QStringList watched = m_watcher.directories();
+
+    QStringList removed;
+    for(const QString &directory : std::as_const(watched)) {
+        if(!directories.contains(directory)) {
+            removed << directory;
+        }
+    }
+
+    QStringList added;
+    for(const QString &directory : directories) {
+        if(!watched.contains(directory)) {
+            added << directory;
+        }
+    }
+
+    if(!removed.isEmpty()) {
+        m_watcher.removePaths(removed);
+    }
+    if(!added.isEmpty()) {
+        m_watcher.addPaths(added);
+    }
+}
+
+void ReplayIndex::updateEntryIndex()
+{
+    m_entryIndex.clear();
+    m_entryIndex.reserve(m_entries.size());
+
+    for(qsizetype i = 0; i < m_entries.size(); i++) {
+        m_entryIndex.insert(m_entries[i].fileName, i);
+    }
+}
+
+bool ReplayIndex::load()
+{
+    QFile file(m_indexFile);
+    if(!file.open(QIODevice::ReadOnly)) {
+        // first scan of this directory
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, format = 0;
+    qint64 count = 0;
+    stream >> magic >> format >> count;
+
+    if(magic != INDEX_MAGIC || format != INDEX_FORMAT || count < 0) {
+        qWarning() << "Ignoring replay index" << m_indexFile << "of another format.";
+        return false;
+    }
+
+    QVector<ReplayIndexEntry> entries;
+    for(qint64 i = 0; i < count; i++) {
+        ReplayIndexEntry entry;
+        readIndexEntry(stream, entry);
+
+        if(stream.status() != QDataStream::Ok) {
+            qWarning() << "Replay index" << m_indexFile << "is truncated, rebuilding it.";
+            return false;
+        }
+
+        entries.append(entry);
+    }
+
+    m_entries = entries;
+    updateEntryIndex();
+
+    return true;
+}
+
+bool ReplayIndex::save() const
+{
+    QDir().mkpath(QFileInfo(m_indexFile).absolutePath());
+
+    // written to a temporary file first, so a crash never leaves a partial index
+    QSaveFile file(m_indexFile);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write replay index" << m_indexFile << ":" << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << INDEX_MAGIC << INDEX_FORMAT << qint64(m_entries.size());
+
+    for(const ReplayIndexEntry &entry : m_entries) {
+        writeIndexEntry(stream, entry);
+    }
+
+    return file.commit();
+}
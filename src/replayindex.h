@@ -0,0 +1,99 @@
+#ifndef REPLAYINDEX_H
+#define REPLAYINDEX_H
+
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include "gamestate.h"
+
+// what the index knows about one replay, from its game start event and metadata
+struct ReplayIndexEntry {
+    QString fileName; // absolute path
+
+    // the entry is current while both match the file
+    qint64 size = 0;
+    qint64 modified = 0; // ms since epoch
+
+    bool valid = false; // false if there is no game start, kept so the file is not read again
+    quint32 replayVersion = 0;
+    GameInfo info;
+    PlayerInfo players[NUM_PLAYERS];
+
+    // from the metadata, which is written when the game is over
+    QString startAt, playedOn;
+    qint32 lastFrame = 0;
+};
+
+// the replays of a directory and its subdirectories. only the start of each file is mapped for the
+// game start event, and the metadata is read from the end. the entries are saved in an index file
+// and a rescan only reads files whose size or modification time changed, on the thread pool.
+// the directories are watched while the index is open
+class ReplayIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayIndex(QObject *parent = nullptr);
+    ~ReplayIndex();
+
+    // loads the index file if it exists and starts a scan. without an index file,
+    // one per directory is kept in the cache location of the application
+    bool open(const QString &directory, const QString &indexFile = QString());
+    void close();
+
+    QString directory() const { return m_directory; }
+    QString indexFile() const { return m_indexFile; }
+
+    // reads new and changed replays, scanFinished() is emitted when the entries were updated
+    void rescan();
+    bool isScanning() const { return m_scan != nullptr; }
+
+    // blocks until the scan is done, e.g. for command line use without an event loop
+    void waitForScan();
+
+    // sorted by file name, only changes when a scan finishes
+    const QVector<ReplayIndexEntry> &entries() const { return m_entries; }
+
+    // reads one file without touching the index
+    static ReplayIndexEntry readEntry(const QFileInfo &file);
+
+signals:
+    // read: files that were new or changed, removed: entries of files that are gone
+    void scanFinished(int read, int removed);
+
+private:
+    struct Scan;
+
+    void finishScan(QSharedPointer<Scan> scan);
+    void updateWatchedDirectories(const QStringList &directories);
+    void updateEntryIndex();
+
+    bool load();
+    bool save() const;
+
+    // the game start event is in the first few hundred bytes of the events
+    static const qint64 HEAD_SIZE = 4096;
+
+    // changes often come in bursts, e.g. while Dolphin writes a replay
+    static const int RESCAN_DELAY = 500;
+
+    QString m_directory, m_indexFile;
+
+    QVector<ReplayIndexEntry> m_entries;
+    QHash<QString, qsizetype> m_entryIndex; // file name to position in m_entries
+
+    QThreadPool m_pool;
+    QSharedPointer<Scan> m_scan;
+    bool m_rescanPending = false;
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_rescanTimer;
+};
+
+#endif // REPLAYINDEX_H
@@ -0,0 +1,344 @@
+#include "replayreader.h"
+#include "seekindex.h"
+#include "slpfile.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// runs in the reader thread and feeds the mapped events to the decoder
+class ReplayReaderPrivate : public QObject {
+    Q_OBJECT
+
+public:
+    ReplayReaderPrivate(ReplayReader *reader);
+
+public slots:
+    void play(const QString &fileName, int mode, QSharedPointer<EventDecoder> decoder);
+    void stop();
+    void seek(int frameNumber);
+
+private:
+    void readNext();
+    void reportProgress();
+
+    // fast mode returns to the event loop after this many frames, so stop() is handled, or earlier
+    // when the overlay events of the chunk fill the decoder's StatsEventQueue
+    static const int FAST_CHUNK_FRAMES = 600;
+
+    ReplayReader *m_reader;
+    QTimer *m_timer;
+
+    SlpFile m_file;
+    SeekIndex m_seekIndex;
+    bool m_hasSeekIndex = false; // loaded or built on the first seek
+    QSharedPointer<EventDecoder> m_decoder;
+    ReplayReader::Mode m_mode = ReplayReader::Realtime;
+
+    QByteArrayView m_events;
+    qsizetype m_position = 0;
+    int m_frames = 0;
+    QElapsedTimer m_elapsed;
+
+    // real time mode paces the frames from the last seek
+    qint64 m_paceStart = 0;
+    int m_paceFrames = 0;
+};
+
+ReplayReaderPrivate::ReplayReaderPrivate(ReplayReader *reader)
+    : m_reader(reader), m_timer(new QTimer(this))
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ReplayReaderPrivate::readNext);
+}
+
+void ReplayReaderPrivate::play(const QString &fileName, int mode, QSharedPointer<EventDecoder> decoder)
+{
+    stop();
+
+    if(!m_file.open(fileName)) {
+        QString message = QString("Could not open replay %1: %2").arg(fileName, m_file.errorString());
+        qWarning().noquote() << message;
+
+        QMetaObject::invokeMethod(m_reader, [reader = m_reader, message]() {
+            emit reader->error(message);
+        });
+        return;
+    }
+
+    m_decoder = decoder;
+    m_mode = ReplayReader::Mode(mode);
+    m_events = m_file.rawEvents();
+    m_position = 0;
+    m_frames = 0;
+    m_paceStart = 0;
+    m_paceFrames = 0;
+    m_hasSeekIndex = false;
+
+    m_decoder->resetStream();
+    m_elapsed.start();
+
+    QMetaObject::invokeMethod(m_reader, [reader = m_reader]() {
+        reader->setPlaying(true);
+    });
+
+    // fast mode reads whenever the event loop is idle, real time mode once per frame
+    m_timer->start(m_mode == ReplayReader::Fast ? 0 : 1000 / ReplayReader::FRAME_RATE);
+}
+
+void ReplayReaderPrivate::stop()
+{
+    if(!m_file.isOpen()) {
+        return;
+    }
+
+    m_timer->stop();
+    m_decoder->flush();
+    reportProgress();
+
+    m_events = QByteArrayView();
+    m_file.close();
+    m_decoder.reset();
+
+    QMetaObject::invokeMethod(m_reader, [reader = m_reader]() {
+        reader->setPlaying(false);
+    });
+}
+
+void ReplayReaderPrivate::seek(int frameNumber)
+{
+    if(!m_file.isOpen()) {
+        qWarning() << "ReplayReader: seek without a replay playing.";
+        return;
+    }
+
+    if(!m_hasSeekIndex) {
+        QElapsedTimer indexTimer;
+        indexTimer.start();
+
+        if(!m_seekIndex.open(m_file)) {
+            qWarning() << "ReplayReader: no seek index for" << m_file.fileName();
+            return;
+        }
+
+        m_hasSeekIndex = true;
+        qDebug() << "Seek index with" << m_seekIndex.keyframes().size() << "keyframes ready in" << indexTimer.elapsed() << "ms";
+    }
+
+    QElapsedTimer seekTimer;
+    seekTimer.start();
+
+    m_position = m_seekIndex.seek(*m_decoder, m_events, frameNumber);
+    m_frames = qMax(0, frameNumber - FIRST_FRAME + 1);
+
+    m_paceStart = m_elapsed.elapsed();
+    m_paceFrames = m_frames;
+
+    m_decoder->flush();
+    reportProgress();
+
+    qDebug() << "Seeked to frame" << frameNumber << "in" << seekTimer.nsecsElapsed() / 1000 << "us";
+}
+
+void ReplayReaderPrivate::readNext()
+{
+    int maxFrames = FAST_CHUNK_FRAMES;
+
+    if(m_mode == ReplayReader::Realtime) {
+        // frames that are due by now, catches up if a timeout came late
+        maxFrames = int((m_elapsed.elapsed() - m_paceStart) * ReplayReader::FRAME_RATE / 1000) + 1 - (m_frames - m_paceFrames);
+        if(maxFrames <= 0) {
+            return;
+        }
+    }
+    else if(!m_decoder->hasStatsEventRoom()) {
+        // the GUI has not drained the overlay events of the last chunk yet, look again when idle
+        return;
+    }
+
+    bool fast = m_mode == ReplayReader::Fast;
+    qsizetype parsed = m_decoder->parseEvents(m_events.sliced(m_position), maxFrames, &m_frames, fast);
+    m_position += parsed;
+
+    if(fast) {
+        // the end of a chunk is handed over regardless of the parser's delivery mode, so the GUI
+        // drains the overlay events before the next one fills the queue
+        m_decoder->publish();
+    }
+    else {
+        m_decoder->flush();
+    }
+    reportProgress();
+
+    if(m_decoder->hasUnknownCommand()) {
+        QString message = QString("Replay %1 has an unknown event at offset %2 after %3 frames")
+            .arg(m_file.fileName()).arg(m_position).arg(m_frames);
+        qWarning().noquote() << message;
+
+        stop();
+
+        QMetaObject::invokeMethod(m_reader, [reader = m_reader, message]() {
+            emit reader->error(message);
+        });
+        return;
+    }
+
+    // a file that is still being written can end in an incomplete command
+    if(m_position >= m_events.size() || parsed == 0) {
+        qDebug() << "Replay finished after" << m_frames << "frames in" << m_elapsed.elapsed() << "ms";
+
+        stop();
+
+        QMetaObject::invokeMethod(m_reader, [reader = m_reader]() {
+            emit reader->finished();
+        });
+    }
+}
+
+void ReplayReaderPrivate::reportProgress()
+{
+    int frames = m_frames;
+    qreal progress = m_events.isEmpty() ? 1 : qreal(m_position) / m_events.size();
+    qint64 elapsed = m_elapsed.elapsed();
+
+    QMetaObject::invokeMethod(m_reader, [reader = m_reader, frames, progress, elapsed]() {
+        reader->setProgress(frames, progress, elapsed);
+    });
+}
+
+ReplayReader::ReplayReader(QObject *parent)
+    : QObject{parent}, d(new ReplayReaderPrivate(this))
+{
+    d->moveToThread(&m_readerThread);
+    m_readerThread.start();
+}
+
+ReplayReader::~ReplayReader()
+{
+    QMetaObject::invokeMethod(d, "stop", Qt::BlockingQueuedConnection);
+
+    m_readerThread.quit();
+    m_readerThread.wait();
+
+    delete d;
+}
+
+QString ReplayReader::fileName() const
+{
+    return m_fileName;
+}
+
+void ReplayReader::setFileName(const QString &fileName)
+{
+    if(m_fileName == fileName)
+        return;
+
+    m_fileName = fileName;
+    emit fileNameChanged();
+}
+
+EventParser *ReplayReader::parser() const
+{
+    return m_parser;
+}
+
+void ReplayReader::setParser(EventParser *parser)
+{
+    if(m_parser == parser)
+        return;
+
+    stop();
+
+    m_parser = parser;
+    emit parserChanged();
+}
+
+ReplayReader::Mode ReplayReader::mode() const
+{
+    return m_mode;
+}
+
+void ReplayReader::setMode(Mode mode)
+{
+    if(m_mode == mode)
+        return;
+
+    m_mode = mode;
+    emit modeChanged();
+}
+
+bool ReplayReader::playing() const
+{
+    return m_playing;
+}
+
+int ReplayReader::frames() const
+{
+    return m_frames;
+}
+
+qreal ReplayReader::progress() const
+{
+    return m_progress;
+}
+
+qint64 ReplayReader::elapsed() const
+{
+    return m_elapsed;
+}
+
+bool ReplayReader::play()
+{
+    if(!m_parser) {
+        qWarning() << "ReplayReader: no parser set.";
+        return false;
+    }
+
+    QSharedPointer<EventDecoder> decoder = m_parser->decoder();
+
+    if(decoder->thread() == QThread::currentThread()) {
+        decoder->moveToThread(&m_readerThread);
+    }
+    else if(decoder->thread() != &m_readerThread) {
+        qWarning() << "ReplayReader: decoder already used by another thread.";
+        return false;
+    }
+
+    QMetaObject::invokeMethod(d, [d = d, fileName = m_fileName, mode = m_mode, decoder]() {
+        d->play(fileName, mode, decoder);
+    });
+
+    return true;
+}
+
+void ReplayReader::stop()
+{
+    QMetaObject::invokeMethod(d, "stop");
+}
+
+void ReplayReader::seek(int frameNumber)
+{
+    QMetaObject::invokeMethod(d, [d = d, frameNumber]() {
+        d->seek(frameNumber);
+    });
+}
+
+void ReplayReader::setProgress(int frames, qreal progress, qint64 elapsed)
+{
+    m_frames = frames;
+    m_progress = progress;
+    m_elapsed = elapsed;
+
+    emit progressChanged();
+}
+
+void ReplayReader::setPlaying(bool playing)
+{
+    if(m_playing == playing)
+        return;
+
+    m_playing = playing;
+    emit playingChanged();
+}
+
+#include "replayreader.moc"
@@ -0,0 +1,90 @@
+#ifndef REPLAYREADER_H
+#define REPLAYREADER_H
+
+#include <QObject>
+#include <QThread>
+
+#include "eventparser.h"
+
+class ReplayReaderPrivate;
+
+// plays a recorded .slp file into an EventParser instead of a Dolphin connection.
+// the file is memory mapped and its events are decoded in place in the reader thread
+class ReplayReader : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString fileName READ fileName WRITE setFileName NOTIFY fileNameChanged)
+    Q_PROPERTY(EventParser *parser READ parser WRITE setParser NOTIFY parserChanged)
+    Q_PROPERTY(Mode mode READ mode WRITE setMode NOTIFY modeChanged)
+    Q_PROPERTY(bool playing READ playing NOTIFY playingChanged)
+
+    // of the current or last replay, elapsed time in ms
+    Q_PROPERTY(int frames READ frames NOTIFY progressChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(qint64 elapsed READ elapsed NOTIFY progressChanged)
+
+public:
+    enum Mode {
+        Fast,       // as fast as possible, e.g. to regenerate stats
+        Realtime    // at the game's 60 frames per second, e.g. to replay the overlays
+    };
+    Q_ENUM(Mode)
+
+    static const int FRAME_RATE = 60;
+
+    explicit ReplayReader(QObject *parent = nullptr);
+    ~ReplayReader();
+
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+
+    // the parser's decoder moves to the reader thread, so it cannot be used by a DolphinConnection at the same time
+    EventParser *parser() const;
+    void setParser(EventParser *parser);
+
+    Mode mode() const;
+    void setMode(Mode mode);
+
+    bool playing() const;
+    int frames() const;
+    qreal progress() const;
+    qint64 elapsed() const;
+
+    Q_INVOKABLE bool play();
+    Q_INVOKABLE void stop();
+
+    // continues the playing replay after frameNumber, negative during the countdown. the first seek
+    // builds the replay's seek index or loads it from the .seek file next to it
+    Q_INVOKABLE void seek(int frameNumber);
+
+signals:
+    void fileNameChanged();
+    void parserChanged();
+    void modeChanged();
+    void playingChanged();
+    void progressChanged();
+
+    void finished();
+    void error(const QString &message);
+
+private:
+    friend class ReplayReaderPrivate;
+
+    // called from the reader thread through queued invocations
+    void setProgress(int frames, qreal progress, qint64 elapsed);
+    void setPlaying(bool playing);
+
+    ReplayReaderPrivate *d;
+    QThread m_readerThread;
+
+    QString m_fileName;
+    EventParser *m_parser = nullptr;
+    Mode m_mode = Realtime;
+
+    bool m_playing = false;
+    int m_frames = 0;
+    qreal m_progress = 0;
+    qint64 m_elapsed = 0;
+};
+
+#endif // REPLAYREADER_H
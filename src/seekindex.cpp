@@ -0,0 +1,382 @@
+#include "seekindex.h"
+#include "eventdecoder.h"
+#include "slippieventlayout.h"
+#include "slpfile.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+using namespace EventLayout;
+
+// cache file: magic, format, replay size and modification time, interval, keyframes
+const quint32 SEEK_MAGIC = 0x534c504b; // "SLPK"
+const quint32 SEEK_FORMAT = 1;
+
+// only the characters that sent frames are written, bit playerIndex * 2 + isFollower
+quint8 activeMask(const SeekIndex::Keyframe &keyframe)
+{
+    quint8 mask = 0;
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        for(int slot = 0; slot < 2; slot++) {
+            if(keyframe.characters[i][slot].isActive()) {
+                mask |= 1 << (i * 2 + slot);
+            }
+        }
+    }
+    return mask;
+}
+
+void writeCharacter(QDataStream &stream, const SeekIndex::Character &character)
+{
+    const PlayerStats &s = character.stats;
+    quint8 flags = (character.isLCancel ? 1 : 0) | (character.isFalling ? 2 : 0) | (s.isFastFalling ? 4 : 0);
+
+    stream << s.comboCount << s.lCancelState << qint32(s.framesSinceLCancel) << qint32(s.framesSinceFall)
+           << qint32(s.intangibilityFrames) << qint32(s.wavedashFrame) << double(s.wavedashAngle)
+           << qint32(s.cycloneBPresses) << flags << character.preFrameOffset << character.postFrameOffset;
+}
+
+void readCharacter(QDataStream &stream, SeekIndex::Character &character)
+{
+    PlayerStats &s = character.stats;
+    qint32 framesSinceLCancel = 0, framesSinceFall = 0, intangibilityFrames = 0, wavedashFrame = 0, cycloneBPresses = 0;
+    double wavedashAngle = 0;
+    quint8 flags = 0;
+
+    stream >> s.comboCount >> s.lCancelState >> framesSinceLCancel >> framesSinceFall
+           >> intangibilityFrames >> wavedashFrame >> wavedashAngle
+           >> cycloneBPresses >> flags >> character.preFrameOffset >> character.postFrameOffset;
+
+    s.framesSinceLCancel = framesSinceLCancel;
+    s.framesSinceFall = framesSinceFall;
+    s.intangibilityFrames = intangibilityFrames;
+    s.wavedashFrame = wavedashFrame;
+    s.wavedashAngle = wavedashAngle;
+    s.cycloneBPresses = cycloneBPresses;
+    s.isFastFalling = flags & 4;
+    character.isLCancel = flags & 1;
+    character.isFalling = flags & 2;
+}
+
+void writeKeyframes(QDataStream &stream, const QVector<SeekIndex::Keyframe> &keyframes)
+{
+    stream << qint64(keyframes.size());
+
+    for(const SeekIndex::Keyframe &keyframe : keyframes) {
+        quint8 mask = activeMask(keyframe);
+        stream << keyframe.frameNumber << keyframe.offset << mask;
+
+        for(int c = 0; c < NUM_PLAYERS * 2; c++) {
+            if(mask & (1 << c)) {
+                writeCharacter(stream, keyframe.characters[c / 2][c % 2]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool SeekIndex::open(const SlpFile &file)
+{
+    QString cacheFile = cacheFileName(file.fileName());
+    if(load(cacheFile, file)) {
+        return true;
+    }
+
+    if(!build(file.rawEvents())) {
+        return false;
+    }
+
+    if(file.isComplete()) {
+        save(cacheFile, file);
+    }
+
+    return true;
+}
+
+bool SeekIndex::scanHead(QByteArrayView events)
+{
+    std::fill(std::begin(m_payloadSizes), std::end(m_payloadSizes), 0);
+    m_version = 0;
+    m_headSize = 0;
+
+    bool hasGameStart = false;
+    qsizetype firstFrame = -1;
+
+    // payload sizes, game start and gecko codes come before the first frame
+    CommandWalk walk = forEachCommand(events, m_payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        if(commandByte == EventDecoder::EVENT_FRAME_START || commandByte == EventDecoder::EVENT_PRE_FRAME) {
+            firstFrame = payload.data() - 1 - events.data();
+            return false;
+        }
+
+        if(commandByte == EventDecoder::EVENT_GAME_START) {
+            m_version = replayVersion(quint8(payload[0]), quint8(payload[1]), quint8(payload[2]));
+            hasGameStart = true;
+        }
+        return true;
+    });
+
+    m_headSize = firstFrame >= 0 ? firstFrame : walk.pos;
+    return hasGameStart;
+}
+
+bool SeekIndex::build(QByteArrayView events)
+{
+    m_keyframes.clear();
+    m_eventsSize = events.size();
+
+    if(!scanHead(events)) {
+        return false;
+    }
+
+    // the state only builds up, nothing is published and no overlay events are queued
+    EventDecoder decoder;
+    decoder.beginSeek();
+
+    qint32 preFrameOffsets[NUM_PLAYERS][2], postFrameOffsets[NUM_PLAYERS][2];
+    std::fill(&preFrameOffsets[0][0], &preFrameOffsets[0][0] + NUM_PLAYERS * 2, -1);
+    std::fill(&postFrameOffsets[0][0], &postFrameOffsets[0][0] + NUM_PLAYERS * 2, -1);
+
+    quint16 payloadSizes[256];
+    std::copy(std::begin(m_payloadSizes), std::end(m_payloadSizes), payloadSizes);
+    qsizetype parsed = 0;
+
+    bool hasFrame = false;
+    qint32 highestFrame = 0, nextKeyframe = FIRST_FRAME + KEYFRAME_INTERVAL;
+
+    // the decoder only runs up to each keyframe, in between only the offsets of the frame events are kept
+    forEachCommand(events.sliced(m_headSize), payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        const uchar *command = reinterpret_cast<const uchar *>(payload.data());
+        qsizetype offset = payload.data() - events.data();
+
+        if(commandByte == EventDecoder::EVENT_PRE_FRAME || commandByte == EventDecoder::EVENT_POST_FRAME) {
+            // same offsets in both events
+            quint8 playerIndex = command[PreFrame::PlayerIndex];
+            int slot = command[PreFrame::IsFollower] != 0 ? 1 : 0;
+
+            if(playerIndex < NUM_PLAYERS) {
+                qint32 (&offsets)[NUM_PLAYERS][2] = commandByte == EventDecoder::EVENT_PRE_FRAME ? preFrameOffsets : postFrameOffsets;
+                offsets[playerIndex][slot] = qint32(offset);
+            }
+        }
+        else if(commandByte == EventDecoder::EVENT_FRAME_BOOKEND) {
+            qint32 frame = qFromBigEndian<qint32>(command + FrameBookend::FrameNumber);
+            qsizetype end = offset + payload.size();
+
+            // resent frames after a rollback are never keyframes, the last events are those of this frame then
+            bool isNewFrame = !hasFrame || frame > highestFrame;
+            highestFrame = isNewFrame ? frame : highestFrame;
+            hasFrame = true;
+
+            if(isNewFrame && frame >= nextKeyframe) {
+                decoder.parseEvents(events.sliced(parsed, end - parsed));
+                parsed = end;
+
+                Keyframe keyframe;
+                keyframe.frameNumber = frame;
+                keyframe.offset = end;
+
+                const GameState &game = decoder.gameState();
+                for(int i = 0; i < NUM_PLAYERS; i++) {
+                    for(int slot = 0; slot < 2; slot++) {
+                        const CharacterState &state = slot == 0 ? game.players[i].leader : game.players[i].follower;
+                        Character &character = keyframe.characters[i][slot];
+
+                        character.stats = state.stats;
+                        character.isLCancel = state.isLCancel;
+                        character.isFalling = state.isFalling;
+                        character.preFrameOffset = preFrameOffsets[i][slot];
+                        character.postFrameOffset = postFrameOffsets[i][slot];
+                    }
+                }
+
+                m_keyframes.append(keyframe);
+                nextKeyframe = frame + KEYFRAME_INTERVAL;
+            }
+        }
+    });
+
+    return true;
+}
+
+bool SeekIndex::load(const QString &fileName, const SlpFile &file)
+{
+    QFile cache(fileName);
+    if(!cache.open(QIODevice::ReadOnly)) {
+        // first read of this replay
+        return false;
+    }
+
+    QFileInfo replay(file.fileName());
+
+    QDataStream stream(&cache);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, format = 0;
+    qint64 size = 0, modified = 0, eventsSize = 0;
+    qint32 interval = 0;
+    qint64 count = 0;
+    stream >> magic >> format >> size >> modified >> eventsSize >> interval >> count;
+
+    if(magic != SEEK_MAGIC || format != SEEK_FORMAT || interval != KEYFRAME_INTERVAL) {
+        qWarning() << "Ignoring seek index" << fileName << "of another format.";
+        return false;
+    }
+
+    // written again if the replay changed
+    if(size != replay.size() || modified != replay.lastModified().toMSecsSinceEpoch()
+            || eventsSize != file.rawEvents().size() || count < 0) {
+        return false;
+    }
+
+    if(!scanHead(file.rawEvents())) {
+        return false;
+    }
+
+    QVector<Keyframe> keyframes;
+    for(qint64 k = 0; k < count; k++) {
+        Keyframe keyframe;
+        quint8 mask = 0;
+        stream >> keyframe.frameNumber >> keyframe.offset >> mask;
+
+        for(int c = 0; c < NUM_PLAYERS * 2; c++) {
+            if(mask & (1 << c)) {
+                readCharacter(stream, keyframe.characters[c / 2][c % 2]);
+            }
+        }
+
+        if(stream.status() != QDataStream::Ok || keyframe.offset > eventsSize) {
+            qWarning() << "Seek index" << fileName << "is truncated, rebuilding it.";
+            return false;
+        }
+
+        keyframes.append(keyframe);
+    }
+
+    m_keyframes = keyframes;
+    m_eventsSize = eventsSize;
+
+    return true;
+}
+
+bool SeekIndex::save(const QString &fileName, const SlpFile &file) const
+{
+    QFileInfo replay(file.fileName());
+
+    // written to a temporary file first, so a crash never leaves a partial index
+    QSaveFile cache(fileName);
+    if(!cache.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write seek index" << fileName << ":" << cache.errorString();
+        return false;
+    }
+
+    QDataStream stream(&cache);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << SEEK_MAGIC << SEEK_FORMAT << replay.size() << replay.lastModified().toMSecsSinceEpoch()
+           << m_eventsSize << qint32(KEYFRAME_INTERVAL);
+
+    writeKeyframes(stream, m_keyframes);
+
+    return cache.commit();
+}
+
+qint64 SeekIndex::byteSize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << SEEK_MAGIC << SEEK_FORMAT << qint64(0) << qint64(0) << m_eventsSize << qint32(KEYFRAME_INTERVAL);
+
+    writeKeyframes(stream, m_keyframes);
+
+    return data.size();
+}
+
+const SeekIndex::Keyframe *SeekIndex::keyframeFor(qint32 frameNumber) const
+{
+    auto next = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), frameNumber,
+                                 [](qint32 frame, const Keyframe &keyframe) { return frame < keyframe.frameNumber; });
+
+    return next == m_keyframes.cbegin() ? nullptr : &*(next - 1);
+}
+
+GameState SeekIndex::keyframeState(const Keyframe &keyframe, QByteArrayView events) const
+{
+    GameState game;
+
+    PreFrameData::Decoder preFrameDecoder = PreFrameData::decoder(m_version, m_payloadSizes[EventDecoder::EVENT_PRE_FRAME]);
+    PostFrameData::Decoder postFrameDecoder = PostFrameData::decoder(m_version, m_payloadSizes[EventDecoder::EVENT_POST_FRAME]);
+
+    const uchar *data = reinterpret_cast<const uchar *>(events.data());
+
+    for(int i = 0; i < NUM_PLAYERS; i++) {
+        PlayerState &player = game.players[i];
+
+        for(int slot = 0; slot < 2; slot++) {
+            const Character &character = keyframe.characters[i][slot];
+            CharacterState &state = player.character(slot == 1);
+
+            state.stats = character.stats;
+            state.isLCancel = character.isLCancel;
+            state.isFalling = character.isFalling;
+
+            // the events of the keyframe, analyzeFrame() compares the next frame with them
+            if(character.preFrameOffset >= 0 && character.preFrameOffset + m_payloadSizes[EventDecoder::EVENT_PRE_FRAME] <= events.size()) {
+                preFrameDecoder(state.preFramePrev, data + character.preFrameOffset);
+            }
+
+            if(character.postFrameOffset >= 0 && character.postFrameOffset + m_payloadSizes[EventDecoder::EVENT_POST_FRAME] <= events.size()) {
+                postFrameDecoder(state.postFramePrev, data + character.postFrameOffset);
+            }
+        }
+
+        player.hasFollower = keyframe.characters[i][1].isActive();
+    }
+
+    return game;
+}
+
+qsizetype SeekIndex::seek(EventDecoder &decoder, QByteArrayView events, qint32 frameNumber) const
+{
+    decoder.resetStream();
+    decoder.beginSeek();
+
+    // payload sizes and game start, the frames before the keyframe are skipped
+    qsizetype pos = decoder.parseEvents(events.first(qMin(m_headSize, events.size())));
+
+    const Keyframe *keyframe = keyframeFor(frameNumber);
+    if(keyframe && keyframe->offset <= events.size()) {
+        decoder.resumeAt(keyframeState(*keyframe, events), keyframe->frameNumber);
+        pos = keyframe->offset;
+    }
+
+    // up to the first event of a later frame, also for replays without frame bookends
+    quint16 payloadSizes[256];
+    std::copy(std::begin(m_payloadSizes), std::end(m_payloadSizes), payloadSizes);
+    qsizetype laterFrame = -1;
+
+    CommandWalk walk = forEachCommand(events.sliced(pos), payloadSizes, [&](quint8 commandByte, QByteArrayView payload) {
+        // the frame number comes first in all frame events
+        bool isFrameEvent = commandByte == EventDecoder::EVENT_FRAME_START || commandByte == EventDecoder::EVENT_PRE_FRAME
+                || commandByte == EventDecoder::EVENT_POST_FRAME;
+        if(isFrameEvent && qFromBigEndian<qint32>(payload.data() + PreFrame::FrameNumber) > frameNumber) {
+            laterFrame = payload.data() - 1 - events.data();
+            return false;
+        }
+        return true;
+    });
+
+    qsizetype end = laterFrame >= 0 ? laterFrame : pos + walk.pos;
+
+    return pos + decoder.parseEvents(events.sliced(pos, end - pos));
+}
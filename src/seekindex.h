@@ -0,0 +1,78 @@
+#ifndef SEEKINDEX_H
+#define SEEKINDEX_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <QVector>
+
+#include "gamestate.h"
+
+class EventDecoder;
+class SlpFile;
+
+// keyframes of one replay for random access: every KEYFRAME_INTERVAL frames the offset after the frame
+// bookend and the analysis state of each character. a seek restores the nearest keyframe before the target
+// and decodes at most one interval, instead of every frame from the start. the index is built on the first
+// read and kept next to the replay as <replay>.seek
+class SeekIndex
+{
+public:
+    // 5 seconds of the game
+    static const int KEYFRAME_INTERVAL = 300;
+
+    struct Character {
+        PlayerStats stats;
+        bool isLCancel = false, isFalling = false;
+
+        // the last pre and post frame events, decoded again for the previous frame of analyzeFrame()
+        qint32 preFrameOffset = -1, postFrameOffset = -1;
+
+        bool isActive() const { return preFrameOffset >= 0 || postFrameOffset >= 0; }
+    };
+
+    struct Keyframe {
+        qint32 frameNumber = 0;
+        qint64 offset = 0; // in the events, after the frame bookend
+        Character characters[NUM_PLAYERS][2]; // leader and follower
+    };
+
+    static QString cacheFileName(const QString &replayFileName) { return replayFileName + ".seek"; }
+
+    // loads the cache file if it still matches the replay, otherwise builds the index from its events.
+    // the cache is only written for complete replays, a file that is still being written grows
+    bool open(const SlpFile &file);
+
+    // decodes every frame of the events once, returns false if there is no game start
+    bool build(QByteArrayView events);
+
+    bool load(const QString &fileName, const SlpFile &file);
+    bool save(const QString &fileName, const SlpFile &file) const;
+
+    const QVector<Keyframe> &keyframes() const { return m_keyframes; }
+
+    // the last keyframe at or before frameNumber, nullptr if there is none
+    const Keyframe *keyframeFor(qint32 frameNumber) const;
+
+    // restarts the decoder in seek mode and decodes up to and including frameNumber, from the nearest keyframe.
+    // returns the offset to continue from, the caller's flush() publishes the state as one update
+    qsizetype seek(EventDecoder &decoder, QByteArrayView events, qint32 frameNumber) const;
+
+    // size of the cache file, e.g. for measuring the overhead
+    qint64 byteSize() const;
+
+private:
+    // payload sizes, version and the offset of the first frame event
+    bool scanHead(QByteArrayView events);
+
+    // the analysis state of a keyframe with the previous frames decoded from the events
+    GameState keyframeState(const Keyframe &keyframe, QByteArrayView events) const;
+
+    qint64 m_eventsSize = 0;
+    qsizetype m_headSize = 0;
+    quint32 m_version = 0;
+    quint16 m_payloadSizes[256] = { 0 };
+
+    QVector<Keyframe> m_keyframes;
+};
+
+#endif // SEEKINDEX_H
@@ -0,0 +1,123 @@
+#ifndef SLIPPIEVENTLAYOUT_H
+#define SLIPPIEVENTLAYOUT_H
+
+#include <QByteArrayView>
+#include <QtGlobal>
+
+#include <type_traits>
+
+// offsets into the command data, i.e. the spec offsets minus 1 for the command byte.
+// shared by the struct decoders and the columnar decoder
+namespace EventLayout {
+
+namespace PreFrame {
+constexpr qsizetype FrameNumber = 0x00, PlayerIndex = 0x04, IsFollower = 0x05, RandomSeed = 0x06,
+    ActionStateId = 0x0A, PosX = 0x0C, PosY = 0x10, FacingDirection = 0x14,
+    JoyStickX = 0x18, JoyStickY = 0x1C, CStickX = 0x20, CStickY = 0x24, TriggerValue = 0x28,
+    ProcessedButtons = 0x2C, PhysicalButtons = 0x30, PhysicalLTrigger = 0x32, PhysicalRTrigger = 0x36,
+    UcfX = 0x3A, Percent = 0x3B, UcfY = 0x3F;
+}
+
+namespace PostFrame {
+constexpr qsizetype FrameNumber = 0x00, PlayerIndex = 0x04, IsFollower = 0x05, CharId = 0x06,
+    ActionStateId = 0x07, PosX = 0x09, PosY = 0x0D, FacingDirection = 0x11, Percent = 0x15, ShieldSize = 0x19,
+    LastHitAttackId = 0x1D, ComboCount = 0x1E, LastHitBy = 0x1F, Stocks = 0x20, ActionStateFrameCounter = 0x21,
+    StateFlags = 0x25, ActionStateData = 0x2A, Airborne = 0x2E, LastGroundId = 0x2F,
+    JumpsRemaining = 0x31, LCancelStatus = 0x32, HurtboxCollisionState = 0x33,
+    XSpeedSelfAir = 0x34, YSpeedSelf = 0x38, XSpeedAttack = 0x3C, YSpeedAttack = 0x40, XSpeedSelfGround = 0x44,
+    HitlagFrameRemaining = 0x48, AnimationIndex = 0x4C;
+}
+
+namespace ItemUpdate {
+constexpr qsizetype FrameNumber = 0x00, TypeId = 0x04, State = 0x06, FacingDirection = 0x07,
+    XVelocity = 0x0B, YVelocity = 0x0F, PosX = 0x13, PosY = 0x17, DamageTaken = 0x1B, ExpirationTimer = 0x1D,
+    SpawnId = 0x21, MissileType = 0x25, TurnipFace = 0x26, ChargeShotLaunched = 0x27, ChargePower = 0x28,
+    Owner = 0x29, InstanceId = 0x2A;
+}
+
+namespace FrameBookend {
+constexpr qsizetype FrameNumber = 0x00, LatestFinalizedFrame = 0x04;
+}
+
+// the event that lists the payload size of every command, always the first one
+constexpr quint8 PayloadSizesCommand = 0x35;
+
+}
+
+// where and why forEachCommand() stopped
+struct CommandWalk {
+    enum Status {
+        End,            // every command was passed on
+        Incomplete,     // the last command is cut off, e.g. a file or stream that is still being written
+        UnknownCommand, // a command without a payload size, the events after it cannot be walked
+        Stopped         // the function returned false
+    };
+
+    Status status = End;
+    qsizetype pos = 0; // after the last whole command, where the next walk continues
+};
+
+// walks the commands of raw Slippi events and calls fn(quint8 commandByte, QByteArrayView payload) for each,
+// the payload without the command byte. the payload sizes event updates payloadSizes before it is passed on
+// with its entries as the payload, commands at or above the size of payloadSizes are unknown.
+// fn may return false to stop after a command
+template<size_t N, typename Function>
+CommandWalk forEachCommand(QByteArrayView events, quint16 (&payloadSizes)[N], Function fn)
+{
+    CommandWalk walk;
+    qsizetype &pos = walk.pos;
+
+    while(pos < events.size()) {
+        quint8 commandByte = quint8(events[pos]);
+        qsizetype size;
+
+        if(commandByte == EventLayout::PayloadSizesCommand) {
+            // the length byte counts itself, 3 bytes per entry after it
+            if(pos + 1 >= events.size() || pos + 1 + quint8(events[pos + 1]) > events.size()) {
+                walk.status = CommandWalk::Incomplete;
+                return walk;
+            }
+
+            qsizetype length = quint8(events[pos + 1]);
+            for(qsizetype entry = pos + 2; entry + 3 <= pos + 1 + length; entry += 3) {
+                quint8 command = quint8(events[entry]);
+                if(command < N) {
+                    payloadSizes[command] = quint16(quint8(events[entry + 1]) << 8 | quint8(events[entry + 2]));
+                }
+            }
+
+            size = length;
+        }
+        else {
+            size = commandByte < N ? payloadSizes[commandByte] : 0;
+            if(size == 0) {
+                walk.status = CommandWalk::UnknownCommand;
+                return walk;
+            }
+
+            if(pos + 1 + size > events.size()) {
+                walk.status = CommandWalk::Incomplete;
+                return walk;
+            }
+        }
+
+        // the payload sizes event is passed on without its length byte
+        QByteArrayView payload = commandByte == EventLayout::PayloadSizesCommand
+            ? events.sliced(pos + 2, qMax<qsizetype>(0, size - 1)) : events.sliced(pos + 1, size);
+        pos += 1 + size;
+
+        if constexpr(std::is_same_v<std::invoke_result_t<Function, quint8, QByteArrayView>, bool>) {
+            if(!fn(commandByte, payload)) {
+                walk.status = CommandWalk::Stopped;
+                return walk;
+            }
+        }
+        else {
+            fn(commandByte, payload);
+        }
+    }
+
+    return walk;
+}
+
+#endif // SLIPPIEVENTLAYOUT_H
@@ -1,37 +1,209 @@
 #include "slippievents.h"
+#include "slippieventlayout.h"
 
-PreFrameData::PreFrameData(const QByteArray &data) {
+#include <QtEndian>
 
-    QDataStream stream(data);
-    stream.setByteOrder(QDataStream::ByteOrder::BigEndian);
-    stream.setFloatingPointPrecision(QDataStream::FloatingPointPrecision::SinglePrecision);
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
-    stream >> frameNumber >> playerIndex >> isFollower >> randomSeed >> actionStateId
-        >> posX >> posY >> facingDirection >> joyStickX >> joyStickY >> cstickX >> cstickY >> triggerValue
-        >> processedButtonsData >> physicalButtonsData
-        >> physicalLTrigger >> physicalRTrigger
-        >> ucfX >> percent >> ucfY;
+namespace {
 
-    isEmpty = false;
-}
+using namespace EventLayout;
+
+template<typename M>
+struct MemberType;
+
+template<typename C, typename T>
+struct MemberType<T C::*> { using Type = T; };
+
+// a big-endian field at Offset of the command data, sent since MinVersion.
+// Size differs from the member size for the state flag bytes, which are stored byte by byte
+template<auto Member, qsizetype Offset, quint32 MinVersion,
+         qsizetype Size = sizeof(typename MemberType<decltype(Member)>::Type)>
+struct FieldDef {
+    using Type = typename MemberType<decltype(Member)>::Type;
+
+    static constexpr quint32 MIN_VERSION = MinVersion;
+    static constexpr qsizetype END = Offset + Size;
+
+    template<typename Data>
+    static void read(Data &data, const uchar *command) {
+        if constexpr(std::is_same_v<Type, bool>) {
+            data.*Member = command[Offset] != 0;
+        }
+        else if constexpr(Size != sizeof(Type)) {
+            // flag byte n in bits 8 * n
+            Type value = 0;
+            for(qsizetype i = 0; i < Size; i++) {
+                value |= Type(command[Offset + i]) << (8 * i);
+            }
+            data.*Member = value;
+        }
+        else if constexpr(Size == 1) {
+            data.*Member = Type(command[Offset]);
+        }
+        else {
+            data.*Member = qFromBigEndian<Type>(command + Offset);
+        }
+    }
+};
+
+// the fields of an event in payload order. newer versions only append fields,
+// so every replay sends a prefix of the list and there is one decoder per prefix length
+template<typename Data, typename... Fields>
+struct Schema {
+    static constexpr int FIELD_COUNT = sizeof...(Fields);
+    static constexpr std::array<quint32, FIELD_COUNT> MIN_VERSIONS = { Fields::MIN_VERSION... };
+    static constexpr std::array<qsizetype, FIELD_COUNT> ENDS = { Fields::END... };
+
+    static_assert(FIELD_COUNT == int(Data::Field::Count), "schema does not match the Field enum");
+
+    static constexpr bool isAppendOnly() {
+        for(int i = 1; i < FIELD_COUNT; i++) {
+            if(ENDS[i] <= ENDS[i - 1] || MIN_VERSIONS[i] < MIN_VERSIONS[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(isAppendOnly(), "fields must be ordered by offset and version");
+
+    // fields that are sent by the version and fit completely into the payload
+    static int presentFields(quint32 version, qsizetype payloadSize) {
+        int count = 0;
+        while(count < FIELD_COUNT && MIN_VERSIONS[count] <= version && ENDS[count] <= payloadSize) {
+            count++;
+        }
+        return count;
+    }
+
+    template<std::size_t... I>
+    static void readFields([[maybe_unused]] Data &data, [[maybe_unused]] const uchar *command, std::index_sequence<I...>) {
+        (std::tuple_element_t<I, std::tuple<Fields...>>::read(data, command), ...);
+    }
 
-PostFrameData::PostFrameData(const QByteArray &data) {
+    template<int Count>
+    static void decode(Data &data, const uchar *command) {
+        readFields(data, command, std::make_index_sequence<Count>());
+        data.fieldCount = Count;
+    }
 
-    QDataStream stream(data);
-    stream.setByteOrder(QDataStream::ByteOrder::BigEndian);
-    stream.setFloatingPointPrecision(QDataStream::FloatingPointPrecision::SinglePrecision);
+    template<std::size_t... Counts>
+    static constexpr std::array<typename Data::Decoder, sizeof...(Counts)> decoders(std::index_sequence<Counts...>) {
+        return { &decode<int(Counts)>... };
+    }
 
-    stream >> frameNumber >> playerIndex >> isFollower >> charId >> actionStateId
-        >> posX >> posY >> facingDirection >> percent >> shieldSize
-        >> lastHitAttackId >> comboCount >> lastHitBy >> stocks >> actionStateFrameCounter;
+    static typename Data::Decoder decoder(quint32 version, qsizetype payloadSize) {
+        static constexpr auto table = decoders(std::make_index_sequence<FIELD_COUNT + 1>());
+        return table[presentFields(version, payloadSize)];
+    }
+};
 
-    // read directly into bit fields
-    stream.readRawData(&bitFlagStart, 5);
+using Pre = PreFrameData;
+using PreFrameSchema = Schema<Pre,
+    FieldDef<&Pre::frameNumber,      PreFrame::FrameNumber,      replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::playerIndex,      PreFrame::PlayerIndex,      replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::isFollower,       PreFrame::IsFollower,       replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::randomSeed,       PreFrame::RandomSeed,       replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::actionStateId,    PreFrame::ActionStateId,    replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::posX,             PreFrame::PosX,             replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::posY,             PreFrame::PosY,             replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::facingDirection,  PreFrame::FacingDirection,  replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::joyStickX,        PreFrame::JoyStickX,        replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::joyStickY,        PreFrame::JoyStickY,        replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::cstickX,          PreFrame::CStickX,          replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::cstickY,          PreFrame::CStickY,          replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::triggerValue,     PreFrame::TriggerValue,     replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::processedButtons, PreFrame::ProcessedButtons, replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::physicalButtons,  PreFrame::PhysicalButtons,  replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::physicalLTrigger, PreFrame::PhysicalLTrigger, replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::physicalRTrigger, PreFrame::PhysicalRTrigger, replayVersion(0, 1, 0)>,
+    FieldDef<&Pre::ucfX,             PreFrame::UcfX,             replayVersion(1, 2, 0)>,
+    FieldDef<&Pre::percent,          PreFrame::Percent,          replayVersion(1, 4, 0)>,
+    FieldDef<&Pre::ucfY,             PreFrame::UcfY,             replayVersion(3, 15, 0)>>;
 
-    stream >> actionStateData >> airborne >> lastGroundId
-        >> jumpsRemaining >> lCancelStatus >> hurtboxCollisionState
-        >> xSpeedSelfAir >> ySpeedSelf >> xSpeedAttack >> ySpeedAttack >> xSpeedSelfGround
-        >> hitlagFrameRemaining >> animationIndex;
+using Post = PostFrameData;
+using PostFrameSchema = Schema<Post,
+    FieldDef<&Post::frameNumber,             PostFrame::FrameNumber,             replayVersion(0, 1, 0)>,
+    FieldDef<&Post::playerIndex,             PostFrame::PlayerIndex,             replayVersion(0, 1, 0)>,
+    FieldDef<&Post::isFollower,              PostFrame::IsFollower,              replayVersion(0, 1, 0)>,
+    FieldDef<&Post::charId,                  PostFrame::CharId,                  replayVersion(0, 1, 0)>,
+    FieldDef<&Post::actionStateId,           PostFrame::ActionStateId,           replayVersion(0, 1, 0)>,
+    FieldDef<&Post::posX,                    PostFrame::PosX,                    replayVersion(0, 1, 0)>,
+    FieldDef<&Post::posY,                    PostFrame::PosY,                    replayVersion(0, 1, 0)>,
+    FieldDef<&Post::facingDirection,         PostFrame::FacingDirection,         replayVersion(0, 1, 0)>,
+    FieldDef<&Post::percent,                 PostFrame::Percent,                 replayVersion(0, 1, 0)>,
+    FieldDef<&Post::shieldSize,              PostFrame::ShieldSize,              replayVersion(0, 1, 0)>,
+    FieldDef<&Post::lastHitAttackId,         PostFrame::LastHitAttackId,         replayVersion(0, 1, 0)>,
+    FieldDef<&Post::comboCount,              PostFrame::ComboCount,              replayVersion(0, 1, 0)>,
+    FieldDef<&Post::lastHitBy,               PostFrame::LastHitBy,               replayVersion(0, 1, 0)>,
+    FieldDef<&Post::stocks,                  PostFrame::Stocks,                  replayVersion(0, 1, 0)>,
+    FieldDef<&Post::actionStateFrameCounter, PostFrame::ActionStateFrameCounter, replayVersion(0, 2, 0)>,
+    FieldDef<&Post::stateFlags,              PostFrame::StateFlags,              replayVersion(2, 0, 0), 5>,
+    FieldDef<&Post::actionStateData,         PostFrame::ActionStateData,         replayVersion(2, 0, 0)>,
+    FieldDef<&Post::airborne,                PostFrame::Airborne,                replayVersion(2, 0, 0)>,
+    FieldDef<&Post::lastGroundId,            PostFrame::LastGroundId,            replayVersion(2, 0, 0)>,
+    FieldDef<&Post::jumpsRemaining,          PostFrame::JumpsRemaining,          replayVersion(2, 0, 0)>,
+    FieldDef<&Post::lCancelStatus,           PostFrame::LCancelStatus,           replayVersion(2, 0, 0)>,
+    FieldDef<&Post::hurtboxCollisionState,   PostFrame::HurtboxCollisionState,   replayVersion(2, 1, 0)>,
+    FieldDef<&Post::xSpeedSelfAir,           PostFrame::XSpeedSelfAir,           replayVersion(3, 5, 0)>,
+    FieldDef<&Post::ySpeedSelf,              PostFrame::YSpeedSelf,              replayVersion(3, 5, 0)>,
+    FieldDef<&Post::xSpeedAttack,            PostFrame::XSpeedAttack,            replayVersion(3, 5, 0)>,
+    FieldDef<&Post::ySpeedAttack,            PostFrame::YSpeedAttack,            replayVersion(3, 5, 0)>,
+    FieldDef<&Post::xSpeedSelfGround,        PostFrame::XSpeedSelfGround,        replayVersion(3, 5, 0)>,
+    FieldDef<&Post::hitlagFrameRemaining,    PostFrame::HitlagFrameRemaining,    replayVersion(3, 8, 0)>,
+    FieldDef<&Post::animationIndex,          PostFrame::AnimationIndex,          replayVersion(3, 11, 0)>>;
+
+using Item = ItemUpdateData;
+using ItemUpdateSchema = Schema<Item,
+    FieldDef<&Item::frameNumber,        ItemUpdate::FrameNumber,        replayVersion(3, 0, 0)>,
+    FieldDef<&Item::typeId,             ItemUpdate::TypeId,             replayVersion(3, 0, 0)>,
+    FieldDef<&Item::state,              ItemUpdate::State,              replayVersion(3, 0, 0)>,
+    FieldDef<&Item::facingDirection,    ItemUpdate::FacingDirection,    replayVersion(3, 0, 0)>,
+    FieldDef<&Item::xVelocity,          ItemUpdate::XVelocity,          replayVersion(3, 0, 0)>,
+    FieldDef<&Item::yVelocity,          ItemUpdate::YVelocity,          replayVersion(3, 0, 0)>,
+    FieldDef<&Item::posX,               ItemUpdate::PosX,               replayVersion(3, 0, 0)>,
+    FieldDef<&Item::posY,               ItemUpdate::PosY,               replayVersion(3, 0, 0)>,
+    FieldDef<&Item::damageTaken,        ItemUpdate::DamageTaken,        replayVersion(3, 0, 0)>,
+    FieldDef<&Item::expirationTimer,    ItemUpdate::ExpirationTimer,    replayVersion(3, 0, 0)>,
+    FieldDef<&Item::spawnId,            ItemUpdate::SpawnId,            replayVersion(3, 0, 0)>,
+    FieldDef<&Item::missileType,        ItemUpdate::MissileType,        replayVersion(3, 2, 0)>,
+    FieldDef<&Item::turnipFace,         ItemUpdate::TurnipFace,         replayVersion(3, 2, 0)>,
+    FieldDef<&Item::chargeShotLaunched, ItemUpdate::ChargeShotLaunched, replayVersion(3, 2, 0)>,
+    FieldDef<&Item::chargePower,        ItemUpdate::ChargePower,        replayVersion(3, 2, 0)>,
+    FieldDef<&Item::owner,              ItemUpdate::Owner,              replayVersion(3, 6, 0)>,
+    FieldDef<&Item::instanceId,         ItemUpdate::InstanceId,         replayVersion(3, 16, 0)>>;
+
+using Bookend = FrameBookendData;
+using FrameBookendSchema = Schema<Bookend,
+    FieldDef<&Bookend::frameNumber,          FrameBookend::FrameNumber,          replayVersion(3, 0, 0)>,
+    FieldDef<&Bookend::latestFinalizedFrame, FrameBookend::LatestFinalizedFrame, replayVersion(3, 7, 0)>>;
+
+static_assert(PreFrameSchema::ENDS.back() == PreFrameData::SIZE);
+static_assert(ItemUpdateSchema::ENDS.back() == ItemUpdateData::SIZE);
+static_assert(FrameBookendSchema::ENDS.back() == FrameBookendData::SIZE);
+static_assert(PostFrameSchema::ENDS.back() + 4 == PostFrameData::SIZE); // followed by 2 instance ids
+
+}
+
+PreFrameData::Decoder PreFrameData::decoder(quint32 version, qsizetype payloadSize)
+{
+    return PreFrameSchema::decoder(version, payloadSize);
+}
+
+PostFrameData::Decoder PostFrameData::decoder(quint32 version, qsizetype payloadSize)
+{
+    return PostFrameSchema::decoder(version, payloadSize);
+}
+
+ItemUpdateData::Decoder ItemUpdateData::decoder(quint32 version, qsizetype payloadSize)
+{
+    return ItemUpdateSchema::decoder(version, payloadSize);
+}
 
-    isEmpty = false;
+FrameBookendData::Decoder FrameBookendData::decoder(quint32 version, qsizetype payloadSize)
+{
+    return FrameBookendSchema::decoder(version, payloadSize);
 }
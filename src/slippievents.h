@@ -1,88 +1,183 @@
 #ifndef SLIPPIEVENTS_H
 #define SLIPPIEVENTS_H
 
-#include <QObject>
+#include <QtGlobal>
+
+// replay version from the game start event, compares in release order
+constexpr quint32 replayVersion(quint8 major, quint8 minor, quint8 build)
+{
+    return quint32(major) << 24 | quint32(minor) << 16 | quint32(build) << 8;
+}
 
 // from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#pre-frame-update
+// fields ordered by size so the struct has no padding holes
 struct PreFrameData {
-    PreFrameData() = default;
-    PreFrameData(const PreFrameData &other) = default;
-    PreFrameData &operator=(const PreFrameData &other) = default;
-
-    PreFrameData(const QByteArray &data);
-
-    bool isEmpty = true;
-
-    qint32 frameNumber;
-    quint8 playerIndex;
-    bool isFollower;
-    quint32 randomSeed;
-    quint16 actionStateId;
-    float posX, posY, facingDirection,
-        joyStickX, joyStickY, cstickX, cstickY, triggerValue;
-
-    struct Buttons {
-        bool dpadLeft : 1, dpadRight : 1, dpadDown: 1, dpadUp: 1;
-        bool z : 1, r : 1, l : 1;
-        bool unused : 1;
-        bool a : 1, b : 1, x : 1, y : 1;
-        bool start : 1;
-        quint8 unused2 : 3;
+    // payload size without the command byte
+    static constexpr qsizetype SIZE = 64;
+
+    // fields in payload order. older versions send fewer of them, see has()
+    enum class Field : quint8 {
+        FrameNumber, PlayerIndex, IsFollower, RandomSeed, ActionStateId,
+        PosX, PosY, FacingDirection, JoyStickX, JoyStickY, CStickX, CStickY, TriggerValue,
+        ProcessedButtons, PhysicalButtons, PhysicalLTrigger, PhysicalRTrigger,
+        UcfX, Percent, UcfY,
+        Count
     };
 
-    struct ProcessedButtons {
-        Buttons physicalButtons;
-        bool joyStickUp : 1, joyStickDown : 1, joyStickLeft: 1, joyStickRight: 1;
-        bool cStickUp : 1, cStickDown : 1, cStickLeft: 1, cStickRight: 1;
-        quint8 unused : 7;
-        bool anyTrigger : 1;
+    // reads the fields a replay sends from the command data, pick once per game with decoder()
+    using Decoder = void (*)(PreFrameData &data, const uchar *command);
+    static Decoder decoder(quint32 version, qsizetype payloadSize);
+
+    // bits of processedButtons, the lower 16 bits are also used in physicalButtons
+    enum Button : quint32 {
+        DpadLeft  = 0x0001, DpadRight = 0x0002, DpadDown = 0x0004, DpadUp = 0x0008,
+        Z         = 0x0010, R         = 0x0020, L        = 0x0040,
+        A         = 0x0100, B         = 0x0200, X        = 0x0400, Y      = 0x0800,
+        Start     = 0x1000,
+
+        JoyStickUp = 0x010000, JoyStickDown = 0x020000, JoyStickLeft = 0x040000, JoyStickRight = 0x080000,
+        CStickUp   = 0x100000, CStickDown   = 0x200000, CStickLeft   = 0x400000, CStickRight   = 0x800000,
+        AnyTrigger = 0x80000000
     };
 
-    union { ProcessedButtons processedButtons; quint32 processedButtonsData; };
-    union { Buttons physicalButtons;           quint16 physicalButtonsData;  };
+    bool isProcessed(Button button) const { return processedButtons & button; }
+    bool isPressed(Button button) const { return physicalButtons & button; }
+
+    qint32 frameNumber = 0;
+    quint32 randomSeed = 0;
+    float posX = 0, posY = 0, facingDirection = 0,
+        joyStickX = 0, joyStickY = 0, cstickX = 0, cstickY = 0, triggerValue = 0;
+    quint32 processedButtons = 0;
+    float physicalLTrigger = 0, physicalRTrigger = 0;
+    float percent = 0;
+
+    quint16 actionStateId = 0;
+    quint16 physicalButtons = 0;
 
-    float physicalLTrigger, physicalRTrigger;
-    qint8 ucfX;
-    float percent;
-    qint8 ucfY;
+    quint8 playerIndex = 0;
+    bool isFollower = false;
+    qint8 ucfX = 0, ucfY = 0;
+
+    // number of leading fields that were sent, the others keep their default value
+    quint8 fieldCount = 0;
+
+    bool has(Field field) const { return quint8(field) < fieldCount; }
+    bool isEmpty() const { return fieldCount == 0; }
 };
 
 // from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#post-frame-update
 struct PostFrameData {
-    PostFrameData() = default;
-    PostFrameData(const PostFrameData &other) = default;
-    PostFrameData &operator=(const PostFrameData &other) = default;
-
-    PostFrameData(const QByteArray &data);
-
-    bool isEmpty = true;
-
-    qint32 frameNumber;
-    quint8 playerIndex;
-    bool isFollower;
-    quint8 charId;
-    quint16 actionStateId;
-    float posX, posY, facingDirection, percent, shieldSize;
-    quint8 lastHitAttackId, comboCount, lastHitBy, stocks;
-    float actionStateFrameCounter;
-
-    union {
-        char bitFlagStart;
-        struct {
-            quint8 : 4; bool isReflectActive : 1;  quint8 : 3;
-            quint8 : 2; bool hasIntangibility : 1; bool isFastFalling : 1;    quint8 : 1; bool isInHitlag: 1;          quint8 : 2;
-            quint8 : 7; bool isShieldActive : 1;
-            quint8 : 2; bool isInHitStun : 1;      bool isTouchingShield : 1; quint8 : 2; bool isPowershieldActive : 1; quint8 : 2;
-            quint8 : 3; bool isFollowerBit : 1;    bool isSleeping: 1;        quint8 : 1; bool isDead: 1;               bool isOffscreen : 1;
-        };
+    static constexpr qsizetype SIZE = 84;
+
+    enum class Field : quint8 {
+        FrameNumber, PlayerIndex, IsFollower, CharId, ActionStateId,
+        PosX, PosY, FacingDirection, Percent, ShieldSize,
+        LastHitAttackId, ComboCount, LastHitBy, Stocks, ActionStateFrameCounter,
+        StateFlags, ActionStateData, Airborne, LastGroundId, JumpsRemaining, LCancelStatus, HurtboxCollisionState,
+        XSpeedSelfAir, YSpeedSelf, XSpeedAttack, YSpeedAttack, XSpeedSelfGround,
+        HitlagFrameRemaining, AnimationIndex,
+        Count
+    };
+
+    using Decoder = void (*)(PostFrameData &data, const uchar *command);
+    static Decoder decoder(quint32 version, qsizetype payloadSize);
+
+    // the 5 state bit flag bytes, byte n of the spec in bits 8 * (n - 1) to 8 * n - 1
+    enum StateFlag : quint64 {
+        ReflectActive     = 0x10ull,
+        Intangible        = 0x04ull << 8,
+        FastFalling       = 0x08ull << 8,
+        InHitlag          = 0x20ull << 8,
+        ShieldActive      = 0x80ull << 16,
+        InHitstun         = 0x02ull << 24,
+        TouchingShield    = 0x04ull << 24,
+        PowershieldActive = 0x20ull << 24,
+        Follower          = 0x08ull << 32,
+        Sleeping          = 0x10ull << 32,
+        Dead              = 0x40ull << 32,
+        Offscreen         = 0x80ull << 32
     };
 
-    float actionStateData; // eg. hitstun remaining
-    bool airborne;
-    quint16 lastGroundId;
-    quint8 jumpsRemaining, lCancelStatus, hurtboxCollisionState;
-    float xSpeedSelfAir, ySpeedSelf, xSpeedAttack, ySpeedAttack, xSpeedSelfGround, hitlagFrameRemaining;
-    quint32 animationIndex;
+    bool hasFlag(StateFlag flag) const { return stateFlags & flag; }
+    bool isFastFalling() const { return hasFlag(FastFalling); }
+
+    quint64 stateFlags = 0;
+
+    qint32 frameNumber = 0;
+    float posX = 0, posY = 0, facingDirection = 0, percent = 0, shieldSize = 0;
+    float actionStateFrameCounter = 0;
+    float actionStateData = 0; // eg. hitstun remaining
+    float xSpeedSelfAir = 0, ySpeedSelf = 0, xSpeedAttack = 0, ySpeedAttack = 0, xSpeedSelfGround = 0,
+        hitlagFrameRemaining = 0;
+    quint32 animationIndex = 0;
+
+    quint16 actionStateId = 0;
+    quint16 lastGroundId = 0;
+
+    quint8 playerIndex = 0;
+    bool isFollower = false;
+    quint8 charId = 0;
+    quint8 lastHitAttackId = 0, comboCount = 0, lastHitBy = 0, stocks = 0;
+    bool airborne = false;
+    quint8 jumpsRemaining = 0, lCancelStatus = 0, hurtboxCollisionState = 0;
+
+    quint8 fieldCount = 0;
+
+    bool has(Field field) const { return quint8(field) < fieldCount; }
+    bool isEmpty() const { return fieldCount == 0; }
+};
+
+// from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#item-update
+struct ItemUpdateData {
+    static constexpr qsizetype SIZE = 44;
+
+    enum class Field : quint8 {
+        FrameNumber, TypeId, State, FacingDirection, XVelocity, YVelocity, PosX, PosY,
+        DamageTaken, ExpirationTimer, SpawnId,
+        MissileType, TurnipFace, ChargeShotLaunched, ChargePower, Owner, InstanceId,
+        Count
+    };
+
+    using Decoder = void (*)(ItemUpdateData &data, const uchar *command);
+    static Decoder decoder(quint32 version, qsizetype payloadSize);
+
+    qint32 frameNumber = 0;
+    float facingDirection = 0, xVelocity = 0, yVelocity = 0, posX = 0, posY = 0, expirationTimer = 0;
+    quint32 spawnId = 0;
+
+    quint16 typeId = 0;
+    quint16 damageTaken = 0;
+    quint16 instanceId = 0;
+
+    quint8 state = 0;
+    quint8 missileType = 0, turnipFace = 0;
+    bool chargeShotLaunched = false;
+    quint8 chargePower = 0;
+    qint8 owner = -1;
+
+    quint8 fieldCount = 0;
+
+    bool has(Field field) const { return quint8(field) < fieldCount; }
+};
+
+// from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#frame-bookend
+struct FrameBookendData {
+    static constexpr qsizetype SIZE = 8;
+
+    enum class Field : quint8 {
+        FrameNumber, LatestFinalizedFrame,
+        Count
+    };
+
+    using Decoder = void (*)(FrameBookendData &data, const uchar *command);
+    static Decoder decoder(quint32 version, qsizetype payloadSize);
+
+    qint32 frameNumber = 0;
+    qint32 latestFinalizedFrame = 0; // frames after it can still be rolled back
+
+    quint8 fieldCount = 0;
+
+    bool has(Field field) const { return quint8(field) < fieldCount; }
 };
 
 #endif // SLIPPIEVENTS_H
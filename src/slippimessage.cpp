@@ -0,0 +1,251 @@
+#include "slippimessage.h"
+
+#include <QDebug>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+const char *skipSpace(const char *p, const char *end) {
+    while(p < end && isSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// p points after the opening quote, returns pointer to the closing quote or end
+const char *scanString(const char *p, const char *end, bool &hasEscapes) {
+    while(p < end && *p != '"') {
+        if(*p == '\\') {
+            hasEscapes = true;
+            p++;
+        }
+        p++;
+    }
+    return p < end ? p : end;
+}
+
+// skips any value that is not a string or integer (objects, arrays, literals, floats)
+const char *skipValue(const char *p, const char *end, bool &hasEscapes) {
+    int depth = 0;
+    while(p < end) {
+        char c = *p;
+        if(c == '"') {
+            p = scanString(p + 1, end, hasEscapes);
+        }
+        else if(c == '{' || c == '[') {
+            depth++;
+        }
+        else if(c == '}' || c == ']') {
+            if(depth == 0) {
+                return p;
+            }
+            depth--;
+        }
+        else if(c == ',' && depth == 0) {
+            return p;
+        }
+        p++;
+    }
+    return p;
+}
+
+}
+
+bool SlippiMessage::parse(QByteArrayView json)
+{
+    *this = {};
+
+    const char *p = json.data();
+    const char *end = p + json.size();
+
+    p = skipSpace(p, end);
+    if(p == end || *p != '{') {
+        return false;
+    }
+    p++;
+
+    while(true) {
+        p = skipSpace(p, end);
+        if(p == end) {
+            return false;
+        }
+        if(*p == '}') {
+            break;
+        }
+        if(*p == ',') {
+            p++;
+            continue;
+        }
+        if(*p != '"') {
+            return false;
+        }
+
+        const char *keyStart = p + 1;
+        p = scanString(keyStart, end, hasEscapes);
+        if(p == end) {
+            return false;
+        }
+        QByteArrayView key(keyStart, p - keyStart);
+
+        p = skipSpace(p + 1, end);
+        if(p == end || *p != ':') {
+            return false;
+        }
+        p = skipSpace(p + 1, end);
+        if(p == end) {
+            return false;
+        }
+
+        if(*p == '"') {
+            const char *valueStart = p + 1;
+            p = scanString(valueStart, end, hasEscapes);
+            if(p == end) {
+                return false;
+            }
+            QByteArrayView value(valueStart, p - valueStart);
+            p++;
+
+            if(key == "type") {
+                typeName = value;
+            }
+            else if(key == "payload") {
+                payload = value;
+            }
+            else if(key == "nick") {
+                nick = value;
+            }
+            else if(key == "version") {
+                version = value;
+            }
+        }
+        else if(*p == '-' || (*p >= '0' && *p <= '9')) {
+            bool negative = *p == '-';
+            if(negative) {
+                p++;
+            }
+
+            qint64 number = 0;
+            bool overflow = false;
+            while(p < end && *p >= '0' && *p <= '9') {
+                overflow |= number > (std::numeric_limits<qint64>::max() - 9) / 10;
+                number = number * 10 + (*p - '0');
+                p++;
+            }
+            if(negative) {
+                number = -number;
+            }
+
+            // a cursor that does not fit is dropped instead of wrapping around
+            if(overflow) {
+                qWarning() << "Ignoring" << key.toByteArray() << "that does not fit 64 bits.";
+            }
+            else if(key == "cursor") {
+                cursor = number;
+            }
+            else if(key == "next_cursor") {
+                nextCursor = number;
+                hasNextCursor = true;
+            }
+
+            // ignore fractions or exponents, Dolphin only sends integers
+            p = skipValue(p, end, hasEscapes);
+        }
+        else {
+            p = skipValue(p, end, hasEscapes);
+        }
+    }
+
+    type = typeFromName(typeName);
+
+    return true;
+}
+
+QString SlippiMessage::decodeString(QByteArrayView value) const
+{
+    if(!hasEscapes || !std::memchr(value.data(), '\\', value.size())) {
+        return QString::fromUtf8(value);
+    }
+
+    QByteArray utf8;
+    utf8.reserve(value.size());
+
+    for(qsizetype i = 0; i < value.size(); i++) {
+        char c = value[i];
+        if(c != '\\' || i + 1 >= value.size()) {
+            utf8.append(c);
+            continue;
+        }
+
+        c = value[++i];
+        switch(c) {
+        case 'b': utf8.append('\b'); break;
+        case 'f': utf8.append('\f'); break;
+        case 'n': utf8.append('\n'); break;
+        case 'r': utf8.append('\r'); break;
+        case 't': utf8.append('\t'); break;
+        case 'u': {
+            if(i + 4 >= value.size()) {
+                break;
+            }
+
+            bool ok = false;
+            char16_t codeUnit = char16_t(value.sliced(i + 1, 4).toByteArray().toUShort(&ok, 16));
+            i += 4;
+
+            if(ok) {
+                // surrogate pairs arrive as two separate escapes
+                QString unit { QChar(codeUnit) };
+                if(QChar::isHighSurrogate(codeUnit) && i + 6 < value.size()
+                    && value[i + 1] == '\\' && value[i + 2] == 'u') {
+                    char16_t low = char16_t(value.sliced(i + 3, 4).toByteArray().toUShort(&ok, 16));
+                    if(ok && QChar::isLowSurrogate(low)) {
+                        unit.append(QChar(low));
+                        i += 6;
+                    }
+                }
+                utf8.append(unit.toUtf8());
+            }
+            break;
+        }
+        default:
+            // \" \\ \/
+            utf8.append(c);
+            break;
+        }
+    }
+
+    return QString::fromUtf8(utf8);
+}
+
+QByteArray SlippiMessage::decodeLatin1(QByteArrayView value) const
+{
+    if(!hasEscapes || !std::memchr(value.data(), '\\', value.size())) {
+        return value.toByteArray();
+    }
+
+    return decodeString(value).toLatin1();
+}
+
+SlippiMessage::Type SlippiMessage::typeFromName(QByteArrayView name)
+{
+    if(name == "game_event") {
+        return GameEvent;
+    }
+    else if(name == "start_game") {
+        return StartGame;
+    }
+    else if(name == "end_game") {
+        return EndGame;
+    }
+    else if(name == "connect_reply") {
+        return ConnectReply;
+    }
+
+    return Unknown;
+}
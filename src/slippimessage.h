@@ -0,0 +1,34 @@
+#ifndef SLIPPIMESSAGE_H
+#define SLIPPIMESSAGE_H
+
+#include <QByteArrayView>
+#include <QString>
+
+// a single message from the Dolphin spectator server, e.g.
+// {"type":"game_event","cursor":12,"next_cursor":13,"payload":"<base64>"}
+// filled by a scanner that only knows the flat objects Dolphin sends,
+// all views point into the scanned data and are only valid as long as it is.
+struct SlippiMessage {
+    enum Type : quint8 { Unknown, ConnectReply, StartGame, GameEvent, EndGame };
+
+    Type type = Unknown;
+    qint64 cursor = 0, nextCursor = 0;
+    bool hasNextCursor = false; // connect_reply only has it if Dolphin tells where its buffered events end
+
+    QByteArrayView typeName;
+    QByteArrayView payload;        // base64 text of game_event messages
+    QByteArrayView nick, version;  // only sent with connect_reply
+
+    // true if any string value contains JSON escape sequences
+    bool hasEscapes = false;
+
+    bool parse(QByteArrayView json);
+
+    // cold path: un-escape a string value if necessary
+    QString decodeString(QByteArrayView value) const;
+    QByteArray decodeLatin1(QByteArrayView value) const;
+
+    static Type typeFromName(QByteArrayView name);
+};
+
+#endif // SLIPPIMESSAGE_H
@@ -0,0 +1,225 @@
+#include "slpfile.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+namespace {
+
+// from: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md#the-raw-element
+// object start, "raw" key, typed array of uint8 with an int32 count
+constexpr char RAW_HEADER[] = { '{', 'U', 3, 'r', 'a', 'w', '[', '$', 'U', '#', 'l' };
+constexpr qsizetype RAW_HEADER_SIZE = sizeof(RAW_HEADER);
+constexpr qsizetype RAW_OFFSET = RAW_HEADER_SIZE + 4;
+
+// the metadata is a few hundred bytes, more is not a replay written by Slippi
+constexpr qint64 MAX_METADATA_SIZE = 64 * 1024;
+
+// the part of UBJSON that the metadata uses, see https://ubjson.org/type-reference/
+class UbjsonReader
+{
+public:
+    explicit UbjsonReader(QByteArrayView data) : m_data(data) {}
+
+    bool hasError() const { return m_error; }
+
+    // object members up to the closing '}' or the end of the data
+    QVariantMap readMembers() {
+        QVariantMap members;
+
+        while(!m_error && m_pos < m_data.size()) {
+            if(m_data[m_pos] == '}') {
+                m_pos++;
+                break;
+            }
+
+            // keys are strings without the type marker
+            QString key = readString();
+            QVariant value = readValue(next());
+
+            if(!m_error) {
+                members.insert(key, value);
+            }
+        }
+
+        return members;
+    }
+
+private:
+    char next() {
+        if(m_pos >= m_data.size()) {
+            m_error = true;
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+
+    // length bytes at the read position, nullptr if there are not enough
+    const uchar *take(qint64 length) {
+        if(length < 0 || length > m_data.size() - m_pos) {
+            m_error = true;
+            return nullptr;
+        }
+
+        const uchar *data = reinterpret_cast<const uchar *>(m_data.data() + m_pos);
+        m_pos += length;
+        return data;
+    }
+
+    template<typename T>
+    T readBigEndian() {
+        const uchar *data = take(sizeof(T));
+        return data ? qFromBigEndian<T>(data) : T(0);
+    }
+
+    qint64 readInteger(char type) {
+        switch(type) {
+        case 'i': return readBigEndian<qint8>();
+        case 'U': return readBigEndian<quint8>();
+        case 'I': return readBigEndian<qint16>();
+        case 'l': return readBigEndian<qint32>();
+        case 'L': return readBigEndian<qint64>();
+        default:
+            m_error = true;
+            return 0;
+        }
+    }
+
+    QString readString() {
+        qint64 length = readInteger(next());
+        const uchar *data = take(length);
+        return data ? QString::fromUtf8(reinterpret_cast<const char *>(data), length) : QString();
+    }
+
+    QVariantList readArray() {
+        QVariantList items;
+
+        while(!m_error) {
+            char type = next();
+            if(type == ']') {
+                break;
+            }
+            items.append(readValue(type));
+        }
+
+        return items;
+    }
+
+    QVariant readValue(char type) {
+        switch(type) {
+        case 'Z':
+        case 'N':
+            return QVariant();
+        case 'T':
+            return true;
+        case 'F':
+            return false;
+        case 'i':
+        case 'U':
+        case 'I':
+        case 'l':
+        case 'L':
+            return readInteger(type);
+        case 'd':
+            return readBigEndian<float>();
+        case 'D':
+            return readBigEndian<double>();
+        case 'C':
+            return QString(QChar::fromLatin1(next()));
+        case 'S':
+            return readString();
+        case '{':
+            return readMembers();
+        case '[':
+            return readArray();
+        default:
+            // e.g. the optimized containers, which Slippi only uses for the raw events
+            m_error = true;
+            return QVariant();
+        }
+    }
+
+    QByteArrayView m_data;
+    qsizetype m_pos = 0;
+    bool m_error = false;
+};
+
+}
+
+bool SlpFile::open(const QString &fileName, qint64 headSize)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if(!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    qint64 size = m_file.size();
+    if(size < RAW_OFFSET) {
+        m_error = "File is too small for a replay.";
+        close();
+        return false;
+    }
+
+    qint64 mapSize = headSize > 0 ? qBound<qint64>(RAW_OFFSET, headSize, size) : size;
+
+    m_map = m_file.map(0, mapSize);
+    if(!m_map) {
+        m_error = m_file.errorString();
+        close();
+        return false;
+    }
+
+    if(std::memcmp(m_map, RAW_HEADER, RAW_HEADER_SIZE) != 0) {
+        m_error = "No raw event array at the start of the file.";
+        close();
+        return false;
+    }
+
+    // the length is 0 while Dolphin still writes the file, then the events run until the metadata
+    m_rawLength = qFromBigEndian<quint32>(m_map + RAW_HEADER_SIZE);
+    if(m_rawLength > size - RAW_OFFSET) {
+        m_rawLength = 0;
+    }
+
+    qint64 length = m_rawLength == 0 ? size - RAW_OFFSET : m_rawLength;
+
+    // a head mapping only has the first events
+    m_rawEvents = QByteArrayView(m_map + RAW_OFFSET, qMin(length, mapSize - RAW_OFFSET));
+    m_error.clear();
+
+    return true;
+}
+
+void SlpFile::close()
+{
+    if(m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    m_file.close();
+    m_rawEvents = QByteArrayView();
+    m_rawLength = 0;
+}
+
+QVariantMap SlpFile::readMetadata()
+{
+    if(!m_file.isOpen() || m_rawLength == 0) {
+        return QVariantMap();
+    }
+
+    if(!m_file.seek(RAW_OFFSET + m_rawLength)) {
+        return QVariantMap();
+    }
+
+    // the rest of the top level object: the "metadata" key and its object
+    QByteArray trailer = m_file.read(MAX_METADATA_SIZE);
+
+    UbjsonReader reader(trailer);
+    QVariantMap members = reader.readMembers();
+
+    return members.value("metadata").toMap();
+}
@@ -0,0 +1,39 @@
+#ifndef SLPFILE_H
+#define SLPFILE_H
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QVariantMap>
+
+// a memory mapped .slp replay. the game events are the "raw" array of the UBJSON document,
+// in the same format as the payloads of the spectator stream, see EventDecoder::parseEvents()
+class SlpFile
+{
+public:
+    // maps the whole file, or only its first headSize bytes if headSize > 0, e.g. for the game start
+    bool open(const QString &fileName, qint64 headSize = 0);
+    void close();
+
+    bool isOpen() const { return m_map != nullptr; }
+    QString fileName() const { return m_file.fileName(); }
+
+    // false while Dolphin still writes the file, more events can follow then
+    bool isComplete() const { return m_rawLength > 0; }
+    QString errorString() const { return m_error; }
+
+    // points into the mapping, valid until close()
+    QByteArrayView rawEvents() const { return m_rawEvents; }
+
+    // the UBJSON metadata after the events, e.g. startAt, playedOn, lastFrame and players.
+    // read from the file instead of the mapping, empty while Dolphin still writes the file
+    QVariantMap readMetadata();
+
+private:
+    QFile m_file;
+    uchar *m_map = nullptr;
+    QByteArrayView m_rawEvents;
+    qint64 m_rawLength = 0; // from the header, 0 until the game is over
+    QString m_error;
+};
+
+#endif // SLPFILE_H
@@ -0,0 +1,98 @@
+#include "streamworker.h"
+#include "eventdecoder.h"
+
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+StreamWorker::StreamWorker(QSharedPointer<EventDecoder> decoder, QSharedPointer<StreamStats> stats, QThreadPool *pool)
+    : m_decoder(decoder), m_stats(stats), m_pool(pool)
+{
+}
+
+StreamWorker::~StreamWorker()
+{
+    // only left if the pool was shut down before the queue was drained
+    for(const Task &task : std::as_const(m_tasks)) {
+        if(task.release) {
+            task.release(task.owner);
+        }
+    }
+}
+
+void StreamWorker::postMessage(QByteArrayView data, Release release, void *owner)
+{
+    post(Task { data, release, owner, nullptr });
+}
+
+void StreamWorker::post(std::function<void()> function)
+{
+    post(Task { QByteArrayView(), nullptr, nullptr, std::move(function) });
+}
+
+void StreamWorker::post(Task &&task)
+{
+    bool schedule;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_tasks.append(std::move(task));
+
+        int depth = m_tasks.size();
+        m_stats->queueDepth = depth;
+        if(depth > m_stats->maxQueueDepth) {
+            m_stats->maxQueueDepth = depth;
+        }
+
+        // at most one drain per stream at a time keeps the order
+        schedule = !m_scheduled;
+        m_scheduled = true;
+    }
+
+    if(schedule) {
+        m_pool->start([self = sharedFromThis()]() {
+            self->drain();
+        });
+    }
+}
+
+void StreamWorker::drain()
+{
+    QList<Task> batch;
+    QElapsedTimer timer;
+
+    forever {
+        {
+            QMutexLocker locker(&m_mutex);
+            if(m_tasks.isEmpty()) {
+                m_scheduled = false;
+                return;
+            }
+
+            batch.swap(m_tasks);
+            m_stats->queueDepth = 0;
+        }
+
+        timer.start();
+
+        for(Task &task : batch) {
+            if(task.function) {
+                task.function();
+            }
+            else {
+                m_decoder->parseMessageData(task.data);
+                if(task.release) {
+                    task.release(task.owner);
+                }
+                m_stats->packets++;
+            }
+        }
+
+        // everything queued so far is one batch for the delivery mode
+        m_decoder->flush();
+        m_stats->batches++;
+
+        m_stats->busyTime += timer.nsecsElapsed() / 1000;
+
+        batch.clear();
+    }
+}
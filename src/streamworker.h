@@ -0,0 +1,64 @@
+#ifndef STREAMWORKER_H
+#define STREAMWORKER_H
+
+#include <QEnableSharedFromThis>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <QByteArrayView>
+
+#include <atomic>
+#include <functional>
+
+class EventDecoder;
+class QThreadPool;
+
+// decoding statistics of one stream, written by whichever thread decodes it
+struct StreamStats {
+    std::atomic<qint64> busyTime = 0; // microseconds spent decoding and analyzing
+    std::atomic<quint64> packets = 0;
+    std::atomic<quint64> batches = 0; // drain passes, each ends with a flush of the decoder
+    std::atomic<int> queueDepth = 0, maxQueueDepth = 0;
+};
+
+// runs the decoding of one stream as tasks on a shared thread pool.
+// the tasks of one stream run one after another in the order they were posted,
+// different streams run in parallel on whichever pool threads are idle.
+class StreamWorker : public QEnableSharedFromThis<StreamWorker>
+{
+public:
+    // frees the memory of a posted message, e.g. enet_packet_destroy() on the packet
+    using Release = void (*)(void *owner);
+
+    StreamWorker(QSharedPointer<EventDecoder> decoder, QSharedPointer<StreamStats> stats, QThreadPool *pool);
+    ~StreamWorker();
+
+    // the message data is decoded in place, release(owner) is called once it is no longer needed.
+    // release may be null if the data outlives the worker
+    void postMessage(QByteArrayView data, Release release, void *owner);
+    void post(std::function<void()> function);
+
+private:
+    struct Task {
+        QByteArrayView data;
+        Release release = nullptr;
+        void *owner = nullptr;
+        std::function<void()> function;
+    };
+
+    void post(Task &&task);
+
+    // runs on the pool until the queue is empty
+    void drain();
+
+    QSharedPointer<EventDecoder> m_decoder;
+    QSharedPointer<StreamStats> m_stats;
+    QThreadPool *m_pool;
+
+    QMutex m_mutex;
+    QList<Task> m_tasks;
+    bool m_scheduled = false;
+};
+
+#endif // STREAMWORKER_H
@@ -0,0 +1,44 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// lock-free single producer / single consumer hand-off of the latest value.
+// the writer fills writeBuffer() and calls publish(), the reader calls update()
+// and then reads read(). neither side ever blocks or allocates, the reader
+// always sees the most recently published value and skips older ones.
+template<typename T>
+class TripleBuffer
+{
+public:
+    // writer side
+    T &writeBuffer() { return m_buffers[m_writeIndex]; }
+
+    void publish() {
+        int previous = m_middle.exchange(m_writeIndex | DirtyBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    // reader side, returns true if a new value was published since the last call
+    bool update() {
+        if(!(m_middle.load(std::memory_order_relaxed) & DirtyBit)) {
+            return false;
+        }
+
+        int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        return true;
+    }
+
+    const T &read() const { return m_buffers[m_readIndex]; }
+
+private:
+    static constexpr int IndexMask = 0x3;
+    static constexpr int DirtyBit = 0x4;
+
+    T m_buffers[3];
+    int m_writeIndex = 0, m_readIndex = 1;
+    std::atomic<int> m_middle = 2;
+};
+
+#endif // TRIPLEBUFFER_H